@@ -15,77 +15,624 @@
  */
 
 #include "Adapter.h"
+#include "AdapterWorker.h"
+#include "AdvertisementMonitor.h"
+#include "Bus.h"
+#include "CborProtocol.h"
 #include "Configuration.h"
+#include "ConnectionPool.h"
+#include "GatewayProbe.h"
+#include "GattPoller.h"
+#include "GattStream.h"
+#include "GroupOccupancy.h"
+#include "HistoryService.h"
+#include "PresenceEvents.h"
+#include "PresenceHistory.h"
+#include "ReadingOutlet.h"
+#include "RegistrationCache.h"
 #include "Scanner.h"
 #include "Wolk.h"
 #include "core/model/DeviceTemplate.h"
 #include "core/model/SensorTemplate.h"
+#include "core/protocol/json/JsonProtocol.h"
 #include "core/utilities/Logger.h"
 #include "utils.h"
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <gio/gio.h>
 #include <glib.h>
 #include <iostream>
 #include <iterator>
-#include <map>
 #include <memory>
+#include <mutex>
 #include <random>
+#include <set>
 #include <string>
 #include <sys/time.h>
 #include <thread>
+#include <unordered_map>
 
-wolkabout::Adapter adapter;
+std::vector<std::unique_ptr<wolkabout::Adapter>> adapters;
+std::vector<std::unique_ptr<wolkabout::AdapterWorker>> adapter_workers;
+std::vector<std::unique_ptr<wolkabout::AdvertisementMonitor>> advertisement_monitors;
 wolkabout::Scanner scanner;
 
-std::map<std::string, int> device_status;
+// Coarse monotonic time of the last scan tick that found each device, by its position in the configuration
+std::vector<gint64> last_seen;
+// Coarse monotonic time the current scan window started
+gint64 window_start = 0;
+// Wall clock minus the coarse monotonic clock, taken once per scan tick to timestamp sightings
+gint64 clock_offset = 0;
+// Presence last reported per device, updated by the snapshot and by events
+std::vector<bool> present_devices;
+wolkabout::PresenceEvents presence_events;
+wolkabout::GroupOccupancy group_occupancy;
+
+// Presence history for local queries, marked at every snapshot
+wolkabout::PresenceHistory presence_history;
+std::unique_ptr<wolkabout::HistoryService> history_service;
+std::vector<bool> history_present;
+guint64 previous_tick = 0;
+
+// Readings are kept in the offline store while the gateway is unreachable
+const unsigned PROBE_INTERVAL = 5;
+const unsigned REPLAY_BATCH = 256;
+const guint REPLAY_PERIOD_MS = 100;
+// Batches handed to Wolk whose delivery is not confirmed by a probe yet
+const gsize REPLAY_WINDOW = 64;
+wolkabout::ReadingOutlet reading_outlet;
+std::unique_ptr<wolkabout::GatewayProbe> gateway_probe;
+guint replay_source = 0;
+std::deque<std::pair<gint64, gsize>> replay_batches;
+std::set<std::string> gatt_addresses;
+std::unordered_map<std::string, wolkabout::GattPoller*> actuator_pollers;
+std::vector<wolkabout::GattPoller*> gatt_pollers;
+std::vector<wolkabout::GattStream*> gatt_streams;
+std::vector<int> bluez_subscriptions;
+const guint RESYNC_RETRY_MS = 500;
+const unsigned RESYNC_ATTEMPTS = 20;
+guint resync_source = 0;
+unsigned resync_attempts = 0;
 wolkabout::DeviceConfiguration appConfiguration;
 
-int timer_scan_publish(void* user_data)
+// Devices registered before and unchanged since are added after connecting, a batch at a time
+const unsigned REGISTRATION_BATCH = 100;
+const guint REGISTRATION_PERIOD_MS = 200;
+wolkabout::RegistrationCache registration_cache;
+std::vector<size_t> deferred_devices;
+size_t deferred_added = 0;
+
+// Written on the main loop only, read under the lock by the configuration provider
+wolkabout::ScanSettings scan_settings;
+std::mutex scan_settings_lock;
+int scan_timer = 0;
+
+struct ScanSettingsUpdate
+{
+    wolkabout::Wolk* wolk;
+    wolkabout::ScanSettings settings;
+};
+
+// All adapters scan in the same phase, each on its own thread
+bool scanning()
+{
+    return adapter_workers.front()->scanning();
+}
+
+void start_scan()
+{
+    window_start = wolkabout::coarse_monotonic_time();
+    for (auto& worker : adapter_workers)
+    {
+        worker->start_scan();
+    }
+}
+
+void stop_scan()
+{
+    for (auto& worker : adapter_workers)
+    {
+        worker->stop_scan();
+    }
+}
+
+void set_discovery_filter(int rssi_threshold)
+{
+    for (auto& worker : adapter_workers)
+    {
+        worker->set_discovery_filter(rssi_threshold);
+    }
+}
+
+void calibrate_clock()
+{
+    clock_offset = g_get_real_time() - wolkabout::coarse_monotonic_time();
+}
+
+guint64 to_rtc(gint64 monotonic)
+{
+    return static_cast<guint64>((monotonic + clock_offset) / 1000);
+}
+
+// Monitors match advertisement patterns, so every device has to be a beacon. Decoders need every advertisement and
+// GATT devices a discovered device, those configurations keep discovering.
+bool use_advertisement_monitors()
+{
+    if (!appConfiguration.getAdvertisementMonitor())
+    {
+        return false;
+    }
+    if (appConfiguration.getBeacons().size() == appConfiguration.getDevices().size() &&
+        appConfiguration.getDecoders().empty() && appConfiguration.getGattDevices().empty())
+    {
+        return true;
+    }
+    LOG(WARN) << "Advertisement monitors need every device to be a beacon without a decoder or GATT access, "
+                 "discovering instead";
+    return false;
+}
+
+void monitor_changed(bool active, void* user_data)
+{
+    static_cast<wolkabout::AdapterWorker*>(user_data)->set_monitored(active);
+}
+
+// A monitored device is lost once it was not heard for a scan interval, or for the absence timeout when longer
+void set_monitor_rssi()
+{
+    const unsigned timeout = std::max(scan_settings.absence_timeout, scan_settings.interval);
+    for (auto& monitor : advertisement_monitors)
+    {
+        monitor->set_rssi(scan_settings.rssi_threshold, timeout);
+    }
+}
+
+// Every presence transition goes through here so group occupancy stays current
+void set_present(size_t device, bool present)
+{
+    if (present_devices[device] != present)
+    {
+        present_devices[device] = present;
+        group_occupancy.transition(static_cast<guint32>(device), present);
+    }
+}
+
+void publish_occupancy(guint64 rtc)
+{
+    const auto& groups = appConfiguration.getGroups();
+    for (gsize group : group_occupancy.collect_changed())
+    {
+        reading_outlet.add(groups[group].key, wolkabout::OCCUPANCY_REFERENCE, group_occupancy.count(group), rtc);
+    }
+}
+
+void publish_admission()
+{
+    const auto counters = wolkabout::Scanner::collect_admission();
+    if (counters.throttled > 0)
+    {
+        LOG(WARN) << "Dropped " << counters.throttled << " sightings over the admission rate limit";
+    }
+
+    const auto& moduleKey = appConfiguration.getModuleKey();
+    if (!moduleKey.empty())
+    {
+        reading_outlet.add(moduleKey, wolkabout::ADMITTED_REFERENCE, counters.admitted);
+        reading_outlet.add(moduleKey, wolkabout::THROTTLED_REFERENCE, counters.throttled);
+        reading_outlet.add(moduleKey, wolkabout::UNKNOWN_REFERENCE, counters.ignored + counters.unknown);
+    }
+}
+
+gboolean add_deferred_devices(void* user_data)
 {
     wolkabout::Wolk* wolk = (wolkabout::Wolk*)user_data;
-    std::vector<std::string> online_devices = wolkabout::Scanner::getDevices();
+    const auto& devices = appConfiguration.getDevices();
 
-    if (adapter.scanning())
+    for (unsigned i = 0; i < REGISTRATION_BATCH && deferred_added < deferred_devices.size(); ++i)
     {
-        int rc = adapter.stop_scan();
-        if (rc)
+        const auto& device = devices[deferred_devices[deferred_added++]];
+        wolk->addDevice(device);
+        reading_outlet.release(device.getKey());
+    }
+
+    if (deferred_added < deferred_devices.size())
+    {
+        return TRUE;
+    }
+
+    if (!deferred_devices.empty())
+    {
+        LOG(INFO) << "Added the " << deferred_devices.size() << " unchanged devices";
+    }
+    deferred_devices.clear();
+
+    // Only now has every device been handed to Wolk
+    registration_cache.save();
+    return FALSE;
+}
+
+guint32 devices_fingerprint(const std::vector<wolkabout::Device>& devices)
+{
+    guint32 fingerprint = 5381;
+    for (const auto& device : devices)
+    {
+        fingerprint = (fingerprint * 33) ^ g_str_hash(device.getKey().c_str());
+    }
+    return fingerprint;
+}
+
+// Drains the offline store in batches at low priority, so live readings are never held back. A batch leaves the store
+// once a probe started after it was published succeeded, batches not confirmed when the gateway is lost are replayed
+// again.
+gboolean replay_readings(void* user_data)
+{
+    wolkabout::Wolk* wolk = (wolkabout::Wolk*)user_data;
+
+    if (reading_outlet.offline())
+    {
+        reading_outlet.rewind();
+        replay_batches.clear();
+        replay_source = 0;
+        return FALSE;
+    }
+
+    while (!replay_batches.empty() && replay_batches.front().first < gateway_probe->last_reachable())
+    {
+        reading_outlet.confirm(replay_batches.front().second);
+        replay_batches.pop_front();
+    }
+
+    if (replay_batches.size() < REPLAY_WINDOW)
+    {
+        const gsize handed = reading_outlet.replay(REPLAY_BATCH);
+        if (handed > 0)
         {
-            LOG(ERROR) << "Unable to stop scanning\n";
-            return FALSE;
+            wolk->publish();
+            replay_batches.emplace_back(g_get_monotonic_time(), handed);
         }
+    }
+    reading_outlet.sync();
+
+    if (reading_outlet.stored() == 0)
+    {
+        LOG(INFO) << "Replayed the stored readings";
+        replay_source = 0;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void replay_offline_store(wolkabout::Wolk* wolk)
+{
+    if (replay_source == 0 && reading_outlet.stored() > 0)
+    {
+        LOG(INFO) << "Replaying " << reading_outlet.stored() << " stored readings";
+        replay_source = g_timeout_add_full(G_PRIORITY_LOW, REPLAY_PERIOD_MS, replay_readings, wolk, NULL);
+    }
+}
+
+void gateway_changed(bool reachable, void* user_data)
+{
+    reading_outlet.set_offline(!reachable);
+    if (reachable)
+    {
+        replay_offline_store((wolkabout::Wolk*)user_data);
+    }
+}
+
+// Publishes arrivals right away instead of waiting for the end of the scan window
+void presence_sighted(const wolkabout::Sighting& sighting, void* user_data)
+{
+    wolkabout::Wolk* wolk = (wolkabout::Wolk*)user_data;
+
+    const size_t device = appConfiguration.findDevice(sighting.key);
+    if (device == wolkabout::DeviceConfiguration::NO_DEVICE || present_devices[device])
+    {
+        return;
+    }
+
+    // Arrivals that are throttled or happen offline are left to the snapshot, which stamps them with the arrival time
+    if (!reading_outlet.offline() && presence_events.allow(sighting.key))
+    {
+        set_present(device, true);
+        reading_outlet.add(sighting.key, "P", 1, to_rtc(sighting.first_seen));
+        wolk->publish(sighting.key);
+    }
+}
+
+void subscribe_bluez()
+{
+    for (int subscription : bluez_subscriptions)
+    {
+        g_dbus_connection_signal_unsubscribe(wolkabout::Bus::connection(), static_cast<guint>(subscription));
+    }
+    bluez_subscriptions.clear();
+
+    bluez_subscriptions.push_back(adapters.front()->subscribe_adapter_changed());
+    bluez_subscriptions.push_back(wolkabout::AdapterWorker::subscribe_device_changed(adapter_workers));
+}
+
+// bluetoothd lost all state, bring adapters, subscriptions and connections back to where they were
+gboolean resync_bluez(void* user_data)
+{
+    (void)user_data;
+
+    // Adapters are registered shortly after bluetoothd takes its name
+    bool powered = true;
+    for (auto& adapter : adapters)
+    {
+        powered = adapter->power_on() == 0 && powered;
+    }
+    if (!powered && ++resync_attempts < RESYNC_ATTEMPTS)
+    {
+        return TRUE;
+    }
+    if (!powered)
+    {
+        LOG(ERROR) << "Unable to enable the adapters after bluetoothd restarted";
+    }
+
+    set_discovery_filter(scan_settings.rssi_threshold);
+    if (scanning())
+    {
+        start_scan();
+    }
+    wolkabout::Scanner::sync();
+    for (auto& monitor : advertisement_monitors)
+        monitor->register_monitor();
+
+    for (auto poller : gatt_pollers)
+        poller->reset();
+    for (auto stream : gatt_streams)
+        stream->reset();
+
+    resync_source = 0;
+    return FALSE;
+}
+
+void bluez_restarted(void* user_data)
+{
+    (void)user_data;
+    LOG(WARN) << "Resynchronising with the restarted bluetoothd";
+
+    subscribe_bluez();
+    for (auto& worker : adapter_workers)
+    {
+        worker->resubscribe();
+    }
+    for (auto& monitor : advertisement_monitors)
+    {
+        monitor->reset();
+    }
+    wolkabout::Scanner::reset();
+
+    resync_attempts = 0;
+    if (resync_source == 0)
+    {
+        resync_source = g_timeout_add(RESYNC_RETRY_MS, resync_bluez, NULL);
+    }
+}
+
+int timer_scan_publish(void* user_data)
+{
+    wolkabout::Wolk* wolk = (wolkabout::Wolk*)user_data;
+    std::vector<wolkabout::Sighting> online_devices = wolkabout::Scanner::getDevices();
 
+    scan_timer = 0;
+
+    if (scanning())
+    {
+        stop_scan();
+
+        calibrate_clock();
+        const gint64 now = wolkabout::coarse_monotonic_time();
+
+        // Earliest and latest detection of each device in this window, readings are stamped with them
+        std::vector<gint64> first_seen(last_seen.size(), 0);
+        std::vector<gint64> last_detected(last_seen.size(), 0);
         for (auto itr = online_devices.begin(); itr != online_devices.end(); itr++)
         {
-            if (device_status.find(*itr) != device_status.end())
+            const size_t device = appConfiguration.findDevice(itr->key);
+
+            // Devices kept known to BlueZ stay listed while out of range, only detections in this window count.
+            // Monitored devices are present until the monitor loses them.
+            const bool seen = itr->monitored || itr->last_seen >= window_start;
+            if (device != wolkabout::DeviceConfiguration::NO_DEVICE)
+            {
+                if (seen)
+                {
+                    LOG(INFO) << "Found the wanted device\n";
+                    last_seen[device] = now;
+                    last_detected[device] = std::max(last_detected[device], itr->monitored ? now : itr->last_seen);
+
+                    const gint64 arrived = std::max(itr->first_seen, window_start);
+                    if (first_seen[device] == 0 || arrived < first_seen[device])
+                    {
+                        first_seen[device] = arrived;
+                    }
+                }
+
+                // Devices polled over GATT must stay known to BlueZ to be connectable, monitors track the others
+                if (gatt_addresses.find(itr->address) == gatt_addresses.end() && !itr->monitored)
+                {
+                    adapter_workers[itr->adapter]->remove_device(
+                      wolkabout::to_object(itr->address, adapters[itr->adapter]->object_path()));
+                }
+            }
+        }
+
+        const gint64 absence = static_cast<gint64>(scan_settings.absence_timeout) * G_USEC_PER_SEC;
+        const bool offline = reading_outlet.offline();
+        const guint64 tick = to_rtc(now) / 1000;
+        if (presence_history.is_open())
+        {
+            presence_history.advance(tick);
+        }
+
+        const auto& devices = appConfiguration.getDevices();
+        for (size_t device = 0; device < devices.size(); ++device)
+        {
+            const bool present = last_seen[device] != 0 && now - last_seen[device] <= absence;
+
+            // Devices seen in this window carry their detection time, the others the time of the tick
+            guint64 rtc = to_rtc(now);
+            if (present && first_seen[device] != 0)
             {
-                LOG(INFO) << "Found the wanted device\n";
-                device_status[*itr] = 1;
-                adapter.remove_device(wolkabout::to_object(*itr).c_str());
+                rtc = to_rtc(present_devices[device] ? last_detected[device] : first_seen[device]);
             }
+
+            // Present since the previous snapshot, or since it arrived in this window
+            if (presence_history.is_open() && present)
+            {
+                guint64 since = tick;
+                if (history_present[device])
+                {
+                    since = previous_tick;
+                }
+                else if (first_seen[device] != 0)
+                {
+                    since = to_rtc(first_seen[device]) / 1000;
+                }
+                presence_history.mark(static_cast<guint32>(device), since, tick);
+            }
+            history_present[device] = present;
+
+            set_present(device, present);
+            reading_outlet.add(devices[device].getKey(), "P", present ? 1 : 0, rtc);
         }
+        previous_tick = tick;
+        presence_history.sync();
 
-        for (auto it = device_status.begin(); it != device_status.end(); it++)
+        publish_occupancy(to_rtc(now));
+        wolkabout::Scanner::publish_signals();
+        publish_admission();
+
+        if (offline)
         {
-            wolk->addSensorReading(it->first, "P", it->second);
-            it->second = 0;
+            reading_outlet.sync();
+            const guint64 evicted = reading_outlet.collect_evicted();
+            if (evicted > 0)
+            {
+                LOG(WARN) << "Offline store is full, dropped the " << evicted << " oldest readings";
+            }
         }
 
         wolk->publish();
+
+        if (scan_settings.interval > scan_settings.window)
+        {
+            scan_timer =
+              scanner.add_timer(scan_settings.interval - scan_settings.window, timer_scan_publish, user_data);
+            return FALSE;
+        }
+    }
+
+    start_scan();
+
+    scan_timer = scanner.add_timer(scan_settings.window, timer_scan_publish, user_data);
+    return FALSE;
+}
+
+gboolean apply_scan_settings(void* user_data)
+{
+    std::unique_ptr<ScanSettingsUpdate> update(static_cast<ScanSettingsUpdate*>(user_data));
+
+    {
+        std::lock_guard<std::mutex> lock(scan_settings_lock);
+        scan_settings = update->settings;
+    }
+
+    set_discovery_filter(scan_settings.rssi_threshold);
+    set_monitor_rssi();
+
+    // Restart the current phase with the new timing, presence and sightings are kept
+    if (scan_timer != 0)
+    {
+        scanner.remove_timer(scan_timer);
+        scan_timer = 0;
+    }
+
+    if (scanning())
+    {
+        scan_timer = scanner.add_timer(scan_settings.window, timer_scan_publish, update->wolk);
+    }
+    else if (scan_settings.interval > scan_settings.window)
+    {
+        scan_timer =
+          scanner.add_timer(scan_settings.interval - scan_settings.window, timer_scan_publish, update->wolk);
     }
     else
     {
-        int rc = adapter.start_scan();
-        if (rc)
+        timer_scan_publish(update->wolk);
+    }
+
+    LOG(INFO) << "Applied scan settings: interval " << scan_settings.interval << "s, window " << scan_settings.window
+              << "s, RSSI threshold " << scan_settings.rssi_threshold << "dBm, absence timeout "
+              << scan_settings.absence_timeout << "s";
+
+    update->wolk->publishConfiguration(appConfiguration.getModuleKey());
+    return G_SOURCE_REMOVE;
+}
+
+bool parseScanSetting(const wolkabout::ConfigurationItem& item, wolkabout::ScanSettings& settings)
+{
+    if (item.getValues().size() != 1)
+    {
+        return false;
+    }
+
+    long value;
+    try
+    {
+        size_t end;
+        value = std::stol(item.getValues().front(), &end);
+        if (end != item.getValues().front().size())
         {
-            LOG(ERROR) << "Unable to scan for new devices\n";
-            return FALSE;
+            return false;
         }
     }
+    catch (std::exception&)
+    {
+        return false;
+    }
 
-    return TRUE;
+    const auto& reference = item.getReference();
+    if (reference == wolkabout::RSSI_THRESHOLD_REFERENCE)
+    {
+        if (value < ADAPTER_RSSI_MIN || value > ADAPTER_RSSI_MAX)
+        {
+            return false;
+        }
+        settings.rssi_threshold = static_cast<int>(value);
+        return true;
+    }
+
+    if (value < 0 || value > G_MAXINT32)
+    {
+        return false;
+    }
+
+    if (reference == wolkabout::SCAN_INTERVAL_REFERENCE)
+    {
+        settings.interval = static_cast<unsigned>(value);
+    }
+    else if (reference == wolkabout::SCAN_WINDOW_REFERENCE)
+    {
+        settings.window = static_cast<unsigned>(value);
+    }
+    else if (reference == wolkabout::ABSENCE_TIMEOUT_REFERENCE)
+    {
+        settings.absence_timeout = static_cast<unsigned>(value);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
 }
 
 int main(int argc, char** argv)
@@ -97,13 +644,13 @@ int main(int argc, char** argv)
     if (argc < 2)
     {
         LOG(ERROR) << "WolkGatewayModule Application: Usage -  " << argv[0]
-                   << " [configurationFilePath] [scanInterval]";
+                   << " [configurationFilePath] [shardIndex/shardCount]";
         return -1;
     }
 
     try
     {
-        appConfiguration = wolkabout::DeviceConfiguration::fromJson(argv[1]);
+        appConfiguration = wolkabout::DeviceConfiguration::fromJson(argv[1], argc > 2 ? argv[2] : "");
     }
     catch (std::logic_error& e)
     {
@@ -113,18 +660,44 @@ int main(int argc, char** argv)
         return -1;
     }
 
+    const auto& shard = appConfiguration.getShard();
+    if (shard.count > 1)
+    {
+        LOG(INFO) << "Shard " << shard.index << " of " << shard.count << " with "
+                  << appConfiguration.getDevices().size() << " devices";
+    }
+
     std::unique_ptr<wolkabout::Wolk> wolk =
       wolkabout::Wolk::newBuilder()
-        .actuationHandler(
-          [&](const std::string& key, const std::string& reference, const std::string& value) -> void {})
-        .actuatorStatusProvider(
-          [&](const std::string& key, const std::string& reference) -> wolkabout::ActuatorStatus {})
+        .actuationHandler([&](const std::string& key, const std::string& reference, const std::string& value) -> void {
+            auto poller = actuator_pollers.find(key);
+            if (poller == actuator_pollers.end() || !poller->second->queue_write(key, reference, value))
+            {
+                LOG(WARN) << "Unknown actuator " << reference << " of device " << key;
+            }
+        })
+        .actuatorStatusProvider([&](const std::string& key, const std::string& reference) -> wolkabout::ActuatorStatus {
+            auto poller = actuator_pollers.find(key);
+            if (poller == actuator_pollers.end())
+            {
+                return wolkabout::ActuatorStatus("", wolkabout::ActuatorStatus::State::ERROR);
+            }
+            return poller->second->actuator_status(key, reference);
+        })
         .deviceStatusProvider([&](const std::string& deviceKey) -> wolkabout::DeviceStatus::Status {
-            auto it =
-              std::find_if(appConfiguration.getDevices().begin(), appConfiguration.getDevices().end(),
-                           [&](const wolkabout::Device& device) -> bool { return (device.getKey() == deviceKey); });
+            if (!appConfiguration.getModuleKey().empty() && deviceKey == appConfiguration.getModuleKey())
+            {
+                return wolkabout::DeviceStatus::Status::CONNECTED;
+            }
+
+            // Groups are counted by the module itself
+            if (appConfiguration.findGroup(deviceKey) != wolkabout::DeviceConfiguration::NO_DEVICE)
+            {
+                return wolkabout::DeviceStatus::Status::CONNECTED;
+            }
 
-            if (it != appConfiguration.getDevices().end())
+            // Configured devices are connected through the module, their presence is the P sensor
+            if (appConfiguration.findDevice(deviceKey) != wolkabout::DeviceConfiguration::NO_DEVICE)
             {
                 return wolkabout::DeviceStatus::Status::CONNECTED;
             }
@@ -132,44 +705,315 @@ int main(int argc, char** argv)
             return wolkabout::DeviceStatus::Status::OFFLINE;
         })
         .configurationHandler(
-          [&](const std::string& deviceKey, const std::vector<wolkabout::ConfigurationItem>& configuration) {})
-        .configurationProvider(
-          [&](const std::string& deviceKey) -> std::vector<wolkabout::ConfigurationItem> { return {}; })
+          [&](const std::string& deviceKey, const std::vector<wolkabout::ConfigurationItem>& configuration) {
+              if (appConfiguration.getModuleKey().empty() || deviceKey != appConfiguration.getModuleKey())
+              {
+                  return;
+              }
+
+              wolkabout::ScanSettings settings;
+              {
+                  std::lock_guard<std::mutex> lock(scan_settings_lock);
+                  settings = scan_settings;
+              }
+
+              for (const auto& item : configuration)
+              {
+                  if (!parseScanSetting(item, settings))
+                  {
+                      LOG(WARN) << "Ignoring invalid scan setting " << item.getReference();
+                  }
+              }
+
+              if (!wolkabout::valid_scan_settings(settings))
+              {
+                  LOG(WARN) << "Rejecting scan settings, the window must fit the interval";
+                  return;
+              }
+
+              // The scanner belongs to the main loop
+              g_idle_add(apply_scan_settings, new ScanSettingsUpdate{wolk.get(), settings});
+          })
+        .configurationProvider([&](const std::string& deviceKey) -> std::vector<wolkabout::ConfigurationItem> {
+            if (appConfiguration.getModuleKey().empty() || deviceKey != appConfiguration.getModuleKey())
+            {
+                return {};
+            }
+
+            std::lock_guard<std::mutex> lock(scan_settings_lock);
+            return {{{std::to_string(scan_settings.interval)}, wolkabout::SCAN_INTERVAL_REFERENCE},
+                    {{std::to_string(scan_settings.window)}, wolkabout::SCAN_WINDOW_REFERENCE},
+                    {{std::to_string(scan_settings.rssi_threshold)}, wolkabout::RSSI_THRESHOLD_REFERENCE},
+                    {{std::to_string(scan_settings.absence_timeout)}, wolkabout::ABSENCE_TIMEOUT_REFERENCE}};
+        })
+        .withDataProtocol(appConfiguration.getProtocol() == wolkabout::PayloadProtocol::CBOR ?
+                            std::unique_ptr<wolkabout::DataProtocol>(new wolkabout::CborProtocol()) :
+                            std::unique_ptr<wolkabout::DataProtocol>(new wolkabout::JsonProtocol()))
         .host(appConfiguration.getLocalMqttUri())
         .build();
 
+    // Every reading goes through the outlet, which stores readings of these keys while the gateway is unreachable
+    std::vector<std::string> readingKeys;
     for (const auto& device : appConfiguration.getDevices())
     {
-        wolk->addDevice(device);
+        readingKeys.push_back(device.getKey());
+    }
+    if (!appConfiguration.getModuleKey().empty())
+    {
+        readingKeys.push_back(appConfiguration.getModuleKey());
+    }
+    for (const auto& group : appConfiguration.getGroups())
+    {
+        readingKeys.push_back(group.key);
+    }
+    reading_outlet.set_wolk(*wolk);
+    reading_outlet.set_keys(readingKeys);
+
+    const bool cached = !appConfiguration.getRegistrationCache().empty();
+    if (cached)
+    {
+        registration_cache.load(appConfiguration.getRegistrationCache());
+    }
+
+    const auto& devices = appConfiguration.getDevices();
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+        const guint64 hash = appConfiguration.getRegistrationHash(i);
+        if (cached && registration_cache.unchanged(devices[i].getKey(), hash))
+        {
+            deferred_devices.push_back(i);
+            reading_outlet.hold(devices[i].getKey());
+        }
+        else
+        {
+            wolk->addDevice(devices[i]);
+        }
+        registration_cache.store(devices[i].getKey(), hash);
+    }
+    if (cached)
+    {
+        LOG(INFO) << "Registering " << devices.size() - deferred_devices.size() << " new or changed devices, "
+                  << deferred_devices.size() << " unchanged ones after connecting";
+    }
+
+    if (!appConfiguration.getModuleKey().empty())
+    {
+        wolk->addDevice(appConfiguration.getModuleDevice());
+    }
+
+    for (const auto& group : appConfiguration.getGroups())
+    {
+        wolk->addDevice(appConfiguration.getGroupDevice(group));
+    }
+
+    scan_settings = appConfiguration.getScanSettings();
+
+    // Each controller has its own connection limit
+    std::vector<std::unique_ptr<wolkabout::ConnectionPool>> connectionPools;
+    std::vector<std::unique_ptr<wolkabout::GattPoller>> gattPollers;
+    std::vector<std::unique_ptr<wolkabout::GattStream>> gattStreams;
+    for (const auto& zone : appConfiguration.getAdapters())
+    {
+        adapters.emplace_back(new wolkabout::Adapter(zone.adapter));
+        connectionPools.emplace_back(new wolkabout::ConnectionPool(appConfiguration.getGattConnections()));
+        gattPollers.emplace_back(new wolkabout::GattPoller(*wolk, reading_outlet, *connectionPools.back(),
+                                                           adapters.back()->object_path()));
+        gattStreams.emplace_back(new wolkabout::GattStream(*wolk, reading_outlet, *connectionPools.back(),
+                                                           adapters.back()->object_path(),
+                                                           appConfiguration.getInterval()));
+    }
+
+    for (const auto& gattDevice : appConfiguration.getGattDevices())
+    {
+        const auto& zones = appConfiguration.getAdapters();
+        const auto adapterIndex = static_cast<size_t>(
+          std::find_if(zones.begin(), zones.end(),
+                       [&](const wolkabout::AdapterZone& zone) { return zone.adapter == gattDevice.adapter; }) -
+          zones.begin());
+        auto& gattPoller = *gattPollers[adapterIndex];
+        auto& gattStream = *gattStreams[adapterIndex];
+
+        if (!gattDevice.notify)
+        {
+            gattPoller.add_device(gattDevice);
+        }
+        else
+        {
+            gattStream.add_device(gattDevice);
+
+            // Actuators of notified devices are still written through the poller, over the stream's connection
+            if (!gattDevice.actuators.empty())
+            {
+                auto actuatorDevice = gattDevice;
+                actuatorDevice.notify = false;
+                actuatorDevice.characteristics.clear();
+                gattPoller.add_device(actuatorDevice, true);
+            }
+        }
+
+        if (!gattDevice.actuators.empty())
+        {
+            actuator_pollers[gattDevice.key] = &gattPoller;
+        }
+        gatt_addresses.insert(gattDevice.address);
     }
 
     wolk->connect();
+    calibrate_clock();
+
+    // The cache is saved once the deferred devices were added, a period after connecting at the earliest
+    if (cached)
+    {
+        g_timeout_add(REGISTRATION_PERIOD_MS, add_deferred_devices, wolk.get());
+    }
+
+    last_seen.assign(appConfiguration.getDevices().size(), 0);
+    present_devices.assign(appConfiguration.getDevices().size(), false);
+    history_present.assign(appConfiguration.getDevices().size(), false);
 
+    std::vector<std::vector<guint32>> groupMembers;
+    for (const auto& group : appConfiguration.getGroups())
+    {
+        groupMembers.emplace_back();
+        for (const auto& member : group.members)
+        {
+            groupMembers.back().push_back(static_cast<guint32>(appConfiguration.findDevice(member)));
+        }
+    }
+    group_occupancy.set_groups(appConfiguration.getDevices().size(), groupMembers);
+    previous_tick = static_cast<guint64>(g_get_real_time() / G_USEC_PER_SEC);
     for (const auto& device : appConfiguration.getDevices())
     {
-        device_status.insert(std::pair<std::string, int>(device.getKey(), 0));
+        wolkabout::Scanner::add_device_key(device.getKey());
+    }
+
+    if (!appConfiguration.getOfflineStore().empty() &&
+        reading_outlet.open_store(appConfiguration.getOfflineStore(), appConfiguration.getOfflineStoreSize() * 1024))
+    {
+        gateway_probe.reset(
+          new wolkabout::GatewayProbe(appConfiguration.getLocalMqttUri(), gateway_changed, (void*)wolk.get()));
+        gateway_probe->start(PROBE_INTERVAL);
+        replay_offline_store(wolk.get());
+    }
+
+    if (!appConfiguration.getPresenceHistory().empty() &&
+        presence_history.open(appConfiguration.getPresenceHistory(),
+                              static_cast<guint32>(appConfiguration.getDevices().size()),
+                              devices_fingerprint(appConfiguration.getDevices()),
+                              appConfiguration.getHistorySettings()))
+    {
+        std::vector<std::string> keys;
+        for (const auto& device : appConfiguration.getDevices())
+        {
+            keys.push_back(device.getKey());
+        }
+        history_service.reset(new wolkabout::HistoryService(presence_history, keys, shard));
+        history_service->start();
+    }
+
+    wolkabout::Scanner::set_outlet(&reading_outlet);
+    wolkabout::Scanner::set_adapters(appConfiguration.getAdapters());
+    wolkabout::Scanner::set_admission(appConfiguration.getAdmissionSettings());
+    if (appConfiguration.getEventSettings().enabled)
+    {
+        presence_events = wolkabout::PresenceEvents(appConfiguration.getEventSettings());
+        wolkabout::Scanner::set_sighting_handler(presence_sighted, (void*)wolk.get());
+    }
+    for (const auto& decoder : appConfiguration.getDecoders())
+    {
+        wolkabout::Scanner::add_decoder(decoder.first, decoder.second);
+    }
+    for (const auto& beacon : appConfiguration.getBeacons())
+    {
+        wolkabout::Scanner::add_beacon(beacon.second, beacon.first);
+    }
+    for (const auto& irk : appConfiguration.getIrks())
+    {
+        wolkabout::Scanner::add_irk(irk.second, irk.first);
+    }
+
+    // Sightings of the other shards' devices are dropped instead of counted as unknown
+    const auto& otherShards = appConfiguration.getOtherShards();
+    for (const auto& key : otherShards.keys)
+    {
+        wolkabout::Scanner::add_foreign_key(key);
+    }
+    for (const auto& beacon : otherShards.beacons)
+    {
+        wolkabout::Scanner::add_beacon(beacon.second, beacon.first);
+    }
+    for (const auto& irk : otherShards.irks)
+    {
+        wolkabout::Scanner::add_irk(irk.second, irk.first);
+    }
+    for (const auto& signal : appConfiguration.getSignalTemplates())
+    {
+        wolkabout::Scanner::add_signal_template(signal.first, signal.second);
     }
 
-    unsigned interval = appConfiguration.getInterval();
+    for (auto& adapter : adapters)
+    {
+        adapter_workers.emplace_back(new wolkabout::AdapterWorker(
+          *adapter, wolkabout::Scanner::device_appeared, wolkabout::Scanner::device_disappeared,
+          wolkabout::Scanner::device_changed));
+        adapter_workers.back()->start();
+    }
+
+    scan_timer = scanner.add_timer(scan_settings.window, timer_scan_publish, (void*)wolk.get());
+    subscribe_bluez();
+    wolkabout::Bus::watch_bluez(bluez_restarted, NULL);
 
-    scanner.add_timer(interval, timer_scan_publish, (void*)wolk.get());
-    adapter.subscribe_adapter_changed();
-    adapter.subscribe_device_added(wolkabout::Scanner::device_appeared);
-    adapter.subscribe_device_removed(wolkabout::Scanner::device_disappeared);
+    for (auto& adapter : adapters)
+    {
+        rc = adapter->power_on();
+        if (rc)
+        {
+            LOG(ERROR) << "Unable to enable the adapter " << adapter->object_path() << "\n";
+        }
+    }
+
+    set_discovery_filter(scan_settings.rssi_threshold);
+    start_scan();
+    wolkabout::Scanner::sync();
+
+    if (use_advertisement_monitors())
+    {
+        std::vector<wolkabout::MonitorPattern> patterns;
+        for (const auto& beacon : appConfiguration.getBeacons())
+        {
+            patterns.push_back(wolkabout::beacon_pattern(beacon.second));
+        }
+        for (size_t i = 0; i < adapters.size(); ++i)
+        {
+            advertisement_monitors.emplace_back(new wolkabout::AdvertisementMonitor(
+              *adapters[i], patterns, monitor_changed, adapter_workers[i].get()));
+        }
+        set_monitor_rssi();
+        for (auto& monitor : advertisement_monitors)
+        {
+            monitor->register_monitor();
+        }
+    }
 
-    rc = adapter.power_on();
-    if (rc)
+    for (auto& gattPoller : gattPollers)
     {
-        LOG(ERROR) << "Unable to enable the adapter\n";
+        if (!gattPoller->empty())
+        {
+            gatt_pollers.push_back(gattPoller.get());
+            gattPoller->start();
+        }
     }
 
-    rc = adapter.start_scan();
-    if (rc)
+    for (auto& gattStream : gattStreams)
     {
-        LOG(ERROR) << "Unable to scan for new devices\n";
+        if (!gattStream->empty())
+        {
+            gatt_streams.push_back(gattStream.get());
+            gattStream->start();
+        }
     }
 
-    adapter.run_loop();
+    wolkabout::Bus::run();
 
     return 0;
 }
@@ -15,12 +15,17 @@
  */
 
 #include "Configuration.h"
+#include "ReadingRing.h"
 
+#include "core/model/ConfigurationTemplate.h"
+#include "core/model/DataType.h"
 #include "core/model/WolkOptional.h"
 #include "core/protocol/json/JsonDto.h"
 #include "core/utilities/FileSystemUtils.h"
 #include "core/utilities/json.hpp"
 
+#include <algorithm>
+#include <set>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -32,15 +37,269 @@ using nlohmann::json;
 wolkabout::SensorTemplate presenceSensor{"Presence", "P", wolkabout::ReadingType::Name::GENERIC,
                                          wolkabout::ReadingType::MeasurmentUnit::NUMERIC, ""};
 
-DeviceTemplate deviceTemplate1{{}, {presenceSensor}, {}, {}};
+namespace
+{
+const unsigned DEFAULT_GATT_CONNECTIONS = 2;
+const double DEFAULT_MEASURED_POWER = -59;
+const double DEFAULT_PATH_LOSS_EXPONENT = 2;
+const double DEFAULT_PROCESS_NOISE = 1;
+const double DEFAULT_MEASUREMENT_NOISE = 16;
+const double DEFAULT_SMOOTHING = 0.3;
+const unsigned DEFAULT_OFFLINE_STORE_SIZE = 1024;
+
+// Bumped whenever the templates built from the configuration change
+const char* const REGISTRATION_VERSION = "1";
+
+GattCharacteristic parseCharacteristic(const json& element, const std::string& key)
+{
+    GattCharacteristic characteristic;
+    characteristic.uuid = element.at("uuid").get<std::string>();
+    characteristic.reference = element.at("reference").get<std::string>();
+    characteristic.name = element.value("name", characteristic.reference);
+    characteristic.offset = element.value("offset", 0u);
+    characteristic.scaled = element.find("scale") != element.end();
+    characteristic.scale = element.value("scale", 1.0);
+
+    const auto format = element.value("format", std::string("uint8"));
+    if (!parse_gatt_format(format, characteristic.format))
+    {
+        throw std::logic_error("Unknown characteristic format '" + format + "' for device " + key);
+    }
+
+    const auto statistic = element.value("statistic", std::string("mean"));
+    if (!parse_gatt_statistic(statistic, characteristic.statistic))
+    {
+        throw std::logic_error("Unknown characteristic statistic '" + statistic + "' for device " + key);
+    }
+
+    return characteristic;
+}
+
+SignalTemplate parseSignalTemplate(const json& element, const std::string& name)
+{
+    SignalTemplate signal;
+    signal.sensors = 0;
+    signal.measured_power = element.value("measuredPower", DEFAULT_MEASURED_POWER);
+    signal.path_loss_exponent = element.value("pathLossExponent", DEFAULT_PATH_LOSS_EXPONENT);
+    if (signal.path_loss_exponent <= 0)
+    {
+        throw std::logic_error("Path loss exponent must be positive in template " + name);
+    }
+
+    signal.process_noise = element.value("processNoise", DEFAULT_PROCESS_NOISE);
+    signal.measurement_noise = element.value("measurementNoise", DEFAULT_MEASUREMENT_NOISE);
+    if (signal.process_noise < 0 || signal.measurement_noise <= 0)
+    {
+        throw std::logic_error("Invalid RSSI filter noise in template " + name);
+    }
+
+    const auto filter = element.value("filter", std::string("kalman"));
+    if (filter == "kalman")
+    {
+        signal.gain = 0;
+    }
+    else if (filter == "ema")
+    {
+        signal.gain = element.value("smoothing", DEFAULT_SMOOTHING);
+        if (signal.gain <= 0 || signal.gain > 1)
+        {
+            throw std::logic_error("Smoothing must be in (0, 1] in template " + name);
+        }
+    }
+    else if (filter == "none")
+    {
+        signal.gain = 1;
+    }
+    else
+    {
+        throw std::logic_error("Unknown RSSI filter '" + filter + "' in template " + name);
+    }
+
+    for (const auto& sensorElement : element.at("sensors"))
+    {
+        const auto sensorName = sensorElement.get<std::string>();
+        SignalSensor sensor;
+        if (!parse_signal_sensor(sensorName, sensor))
+        {
+            throw std::logic_error("Unknown sensor '" + sensorName + "' in template " + name);
+        }
+        signal.sensors |= sensor;
+    }
+
+    return signal;
+}
+
+void addSignalSensors(const SignalTemplate& signal, bool positioned, std::vector<SensorTemplate>& sensors)
+{
+    if (signal.sensors & SIGNAL_RSSI)
+    {
+        sensors.emplace_back("RSSI", "RSSI", wolkabout::ReadingType::Name::GENERIC,
+                             wolkabout::ReadingType::MeasurmentUnit::NUMERIC, "Filtered RSSI in dBm");
+    }
+    if (signal.sensors & SIGNAL_TX_POWER)
+    {
+        sensors.emplace_back("TX power", "TX", wolkabout::ReadingType::Name::GENERIC,
+                             wolkabout::ReadingType::MeasurmentUnit::NUMERIC, "Advertised TX power in dBm");
+    }
+    if (signal.sensors & SIGNAL_DISTANCE)
+    {
+        sensors.emplace_back("Distance", "D", wolkabout::ReadingType::Name::GENERIC,
+                             wolkabout::ReadingType::MeasurmentUnit::NUMERIC, "Estimated distance in metres");
+    }
+    if (signal.sensors & SIGNAL_SIGHTINGS)
+    {
+        sensors.emplace_back("Sightings", "S", wolkabout::ReadingType::Name::GENERIC,
+                             wolkabout::ReadingType::MeasurmentUnit::NUMERIC, "Advertisements seen in the interval");
+    }
+    if (signal.sensors & SIGNAL_ZONE)
+    {
+        sensors.emplace_back("Zone", "Z", wolkabout::ReadingType::Name::GENERIC,
+                             wolkabout::ReadingType::MeasurmentUnit::NUMERIC, "Zone of the strongest adapter");
+        if (positioned)
+        {
+            sensors.emplace_back("Zone X", "ZX", wolkabout::ReadingType::Name::GENERIC,
+                                 wolkabout::ReadingType::MeasurmentUnit::NUMERIC, "Estimated X position");
+            sensors.emplace_back("Zone Y", "ZY", wolkabout::ReadingType::Name::GENERIC,
+                                 wolkabout::ReadingType::MeasurmentUnit::NUMERIC, "Estimated Y position");
+        }
+    }
+}
+
+std::vector<AdapterZone> parseAdapters(const json& j)
+{
+    std::vector<AdapterZone> adapters;
+    if (j.find("adapters") == j.end())
+    {
+        adapters.push_back(AdapterZone{"hci0", 1, false, 0, 0});
+        return adapters;
+    }
+
+    for (const auto& element : j.at("adapters"))
+    {
+        AdapterZone adapter;
+        adapter.adapter = element.at("name").get<std::string>();
+        adapter.zone = element.value("zone", static_cast<unsigned>(adapters.size() + 1));
+        adapter.positioned = element.find("x") != element.end() && element.find("y") != element.end();
+        adapter.x = element.value("x", 0.0);
+        adapter.y = element.value("y", 0.0);
+
+        for (const auto& other : adapters)
+        {
+            if (other.adapter == adapter.adapter)
+            {
+                throw std::logic_error("Adapter " + adapter.adapter + " is listed more than once");
+            }
+        }
+        adapters.push_back(adapter);
+    }
+
+    if (adapters.empty())
+    {
+        throw std::logic_error("At least one adapter must be configured");
+    }
+    return adapters;
+}
+
+std::vector<DeviceGroup> parseGroups(const json& j, const std::vector<Device>& devices, const std::string& moduleKey)
+{
+    std::vector<DeviceGroup> groups;
+    if (j.find("groups") == j.end())
+    {
+        return groups;
+    }
+
+    std::set<std::string> deviceKeys;
+    for (const auto& device : devices)
+    {
+        deviceKeys.insert(device.getKey());
+    }
+
+    std::set<std::string> usedKeys = deviceKeys;
+    if (!moduleKey.empty())
+    {
+        usedKeys.insert(moduleKey);
+    }
+
+    for (const auto& element : j.at("groups"))
+    {
+        DeviceGroup group;
+        group.name = element.at("name").get<std::string>();
+        group.key = str_toupper(element.at("key").get<std::string>());
+        if (!usedKeys.insert(group.key).second)
+        {
+            throw std::logic_error("Group key " + group.key + " is already used");
+        }
+
+        for (const auto& member : element.at("devices"))
+        {
+            const auto key = str_toupper(member.get<std::string>());
+            if (deviceKeys.find(key) == deviceKeys.end())
+            {
+                throw std::logic_error("Unknown device " + key + " in group " + group.key);
+            }
+            if (std::find(group.members.begin(), group.members.end(), key) != group.members.end())
+            {
+                throw std::logic_error("Device " + key + " is listed more than once in group " + group.key);
+            }
+            group.members.push_back(key);
+        }
+        groups.push_back(group);
+    }
+    return groups;
+}
+}    // namespace
 
 DeviceConfiguration::DeviceConfiguration(std::string localMqttUri, unsigned interval,
-                                         std::vector<wolkabout::Device> devices, ValueGenerator generator)
+                                         std::vector<wolkabout::Device> devices, ValueGenerator generator,
+                                         std::map<std::string, const AdvertisementDecoder*> decoders,
+                                         std::map<std::string, BeaconIdentity> beacons,
+                                         std::map<std::string, IdentityResolvingKey> irks,
+                                         std::vector<GattDevice> gattDevices, unsigned gattConnections,
+                                         std::string moduleKey, ScanSettings scanSettings,
+                                         std::map<std::string, SignalTemplate> signalTemplates,
+                                         std::vector<AdapterZone> adapters, AdmissionSettings admissionSettings,
+                                         EventSettings eventSettings, std::string offlineStore,
+                                         unsigned offlineStoreSize, PayloadProtocol protocol,
+                                         bool advertisementMonitor, std::string presenceHistory,
+                                         HistorySettings historySettings, std::vector<DeviceGroup> groups,
+                                         std::string registrationCache, std::vector<guint64> registrationHashes,
+                                         ShardSettings shard, OtherShardDevices otherShards)
 : m_localMqttUri(std::move(localMqttUri))
 , m_interval(interval)
 , m_devices(std::move(devices))
 , m_valueGenerator(generator)
+, m_decoders(std::move(decoders))
+, m_beacons(std::move(beacons))
+, m_irks(std::move(irks))
+, m_gattDevices(std::move(gattDevices))
+, m_gattConnections(gattConnections)
+, m_moduleKey(std::move(moduleKey))
+, m_scanSettings(scanSettings)
+, m_signalTemplates(std::move(signalTemplates))
+, m_adapters(std::move(adapters))
+, m_admissionSettings(admissionSettings)
+, m_eventSettings(eventSettings)
+, m_offlineStore(std::move(offlineStore))
+, m_offlineStoreSize(offlineStoreSize)
+, m_protocol(protocol)
+, m_advertisementMonitor(advertisementMonitor)
+, m_presenceHistory(std::move(presenceHistory))
+, m_historySettings(historySettings)
+, m_groups(std::move(groups))
+, m_registrationCache(std::move(registrationCache))
+, m_registrationHashes(std::move(registrationHashes))
+, m_shard(shard)
+, m_otherShards(std::move(otherShards))
 {
+    m_deviceIndex.reserve(m_devices.size());
+    for (size_t i = 0; i < m_devices.size(); ++i)
+    {
+        m_deviceIndex.emplace(m_devices[i].getKey(), i);
+    }
+    for (size_t i = 0; i < m_groups.size(); ++i)
+    {
+        m_groupIndex.emplace(m_groups[i].key, i);
+    }
 }
 
 const std::string& DeviceConfiguration::getLocalMqttUri() const
@@ -63,7 +322,163 @@ const std::vector<wolkabout::Device>& DeviceConfiguration::getDevices() const
     return m_devices;
 }
 
-wolkabout::DeviceConfiguration DeviceConfiguration::fromJson(const std::string& deviceConfigurationFile)
+const size_t DeviceConfiguration::NO_DEVICE = static_cast<size_t>(-1);
+
+size_t DeviceConfiguration::findDevice(const std::string& key) const
+{
+    const auto it = m_deviceIndex.find(key);
+    return it == m_deviceIndex.end() ? NO_DEVICE : it->second;
+}
+
+const std::map<std::string, const AdvertisementDecoder*>& DeviceConfiguration::getDecoders() const
+{
+    return m_decoders;
+}
+
+const std::map<std::string, BeaconIdentity>& DeviceConfiguration::getBeacons() const
+{
+    return m_beacons;
+}
+
+const std::map<std::string, IdentityResolvingKey>& DeviceConfiguration::getIrks() const
+{
+    return m_irks;
+}
+
+const std::vector<GattDevice>& DeviceConfiguration::getGattDevices() const
+{
+    return m_gattDevices;
+}
+
+unsigned DeviceConfiguration::getGattConnections() const
+{
+    return m_gattConnections;
+}
+
+const std::string& DeviceConfiguration::getModuleKey() const
+{
+    return m_moduleKey;
+}
+
+wolkabout::Device DeviceConfiguration::getModuleDevice() const
+{
+    std::vector<ConfigurationTemplate> configurations{
+      {"Scan interval", SCAN_INTERVAL_REFERENCE, DataType::NUMERIC, "Seconds between scan starts",
+       std::to_string(m_scanSettings.interval)},
+      {"Scan window", SCAN_WINDOW_REFERENCE, DataType::NUMERIC, "Seconds of scanning per interval",
+       std::to_string(m_scanSettings.window)},
+      {"RSSI threshold", RSSI_THRESHOLD_REFERENCE, DataType::NUMERIC, "Weakest accepted signal in dBm",
+       std::to_string(m_scanSettings.rssi_threshold)},
+      {"Absence timeout", ABSENCE_TIMEOUT_REFERENCE, DataType::NUMERIC,
+       "Seconds a device stays present after it was last seen", std::to_string(m_scanSettings.absence_timeout)}};
+
+    std::vector<SensorTemplate> sensors{
+      {"Admitted sightings", ADMITTED_REFERENCE, ReadingType::Name::GENERIC, ReadingType::MeasurmentUnit::NUMERIC,
+       "Sightings of configured devices"},
+      {"Throttled sightings", THROTTLED_REFERENCE, ReadingType::Name::GENERIC, ReadingType::MeasurmentUnit::NUMERIC,
+       "Sightings dropped by the adapter rate limit"},
+      {"Unknown sightings", UNKNOWN_REFERENCE, ReadingType::Name::GENERIC, ReadingType::MeasurmentUnit::NUMERIC,
+       "Sightings of devices that are not configured"}};
+
+    return Device("Bluetooth module", m_moduleKey, DeviceTemplate{configurations, sensors, {}, {}});
+}
+
+const ScanSettings& DeviceConfiguration::getScanSettings() const
+{
+    return m_scanSettings;
+}
+
+const std::map<std::string, SignalTemplate>& DeviceConfiguration::getSignalTemplates() const
+{
+    return m_signalTemplates;
+}
+
+const std::vector<AdapterZone>& DeviceConfiguration::getAdapters() const
+{
+    return m_adapters;
+}
+
+const AdmissionSettings& DeviceConfiguration::getAdmissionSettings() const
+{
+    return m_admissionSettings;
+}
+
+const EventSettings& DeviceConfiguration::getEventSettings() const
+{
+    return m_eventSettings;
+}
+
+const std::string& DeviceConfiguration::getOfflineStore() const
+{
+    return m_offlineStore;
+}
+
+unsigned DeviceConfiguration::getOfflineStoreSize() const
+{
+    return m_offlineStoreSize;
+}
+
+PayloadProtocol DeviceConfiguration::getProtocol() const
+{
+    return m_protocol;
+}
+
+bool DeviceConfiguration::getAdvertisementMonitor() const
+{
+    return m_advertisementMonitor;
+}
+
+const std::string& DeviceConfiguration::getPresenceHistory() const
+{
+    return m_presenceHistory;
+}
+
+const HistorySettings& DeviceConfiguration::getHistorySettings() const
+{
+    return m_historySettings;
+}
+
+const std::vector<DeviceGroup>& DeviceConfiguration::getGroups() const
+{
+    return m_groups;
+}
+
+const std::string& DeviceConfiguration::getRegistrationCache() const
+{
+    return m_registrationCache;
+}
+
+guint64 DeviceConfiguration::getRegistrationHash(size_t device) const
+{
+    return m_registrationHashes[device];
+}
+
+const ShardSettings& DeviceConfiguration::getShard() const
+{
+    return m_shard;
+}
+
+const OtherShardDevices& DeviceConfiguration::getOtherShards() const
+{
+    return m_otherShards;
+}
+
+size_t DeviceConfiguration::findGroup(const std::string& key) const
+{
+    const auto it = m_groupIndex.find(key);
+    return it == m_groupIndex.end() ? NO_DEVICE : it->second;
+}
+
+wolkabout::Device DeviceConfiguration::getGroupDevice(const DeviceGroup& group) const
+{
+    std::vector<SensorTemplate> sensors{{"Occupancy", OCCUPANCY_REFERENCE, ReadingType::Name::GENERIC,
+                                         ReadingType::MeasurmentUnit::NUMERIC, "Present devices of the group"}};
+
+    return Device(group.name, group.key, DeviceTemplate{{}, sensors, {}, {}});
+}
+
+wolkabout::DeviceConfiguration DeviceConfiguration::fromJson(const std::string& deviceConfigurationFile,
+                                                             const std::string& shard)
 {
     if (!FileSystemUtils::isFilePresent(deviceConfigurationFile))
     {
@@ -92,15 +507,264 @@ wolkabout::DeviceConfiguration DeviceConfiguration::fromJson(const std::string&
         }
     }
 
+    PayloadProtocol protocol = PayloadProtocol::JSON;
+    if (j.find("protocol") != j.end())
+    {
+        const auto name = j.at("protocol").get<std::string>();
+        if (name == "cbor")
+        {
+            protocol = PayloadProtocol::CBOR;
+        }
+        else if (name != "json")
+        {
+            throw std::logic_error("Unknown protocol '" + name + "'");
+        }
+    }
+
+    ShardSettings shardSettings = {j.value("shardIndex", 0u), j.value("shardCount", 1u)};
+    if (!shard.empty() && !parse_shard(shard, shardSettings))
+    {
+        throw std::logic_error("Invalid shard '" + shard + "', expected <index>/<count>");
+    }
+    if (!valid_shard_settings(shardSettings))
+    {
+        throw std::logic_error("Invalid shard settings");
+    }
+    if (shardSettings.count > 1 && j.find("groups") != j.end())
+    {
+        throw std::logic_error("Device groups cannot be counted across shards");
+    }
+
     std::vector<Device> devices;
+    std::map<std::string, const AdvertisementDecoder*> decoders;
+    std::map<std::string, BeaconIdentity> beacons;
+    std::map<std::string, IdentityResolvingKey> irks;
+    std::vector<GattDevice> gattDevices;
+
+    const auto adapters = parseAdapters(j);
+    const bool positioned = std::any_of(adapters.begin(), adapters.end(),
+                                        [](const AdapterZone& adapter) { return adapter.positioned; });
+
+    std::map<std::string, SignalTemplate> templates;
+    if (j.find("templates") != j.end())
+    {
+        for (auto it = j.at("templates").begin(); it != j.at("templates").end(); ++it)
+        {
+            templates[it.key()] = parseSignalTemplate(it.value(), it.key());
+        }
+    }
+
+    std::map<std::string, SignalTemplate> signalTemplates;
+    std::vector<guint64> registrationHashes;
+    OtherShardDevices otherShards;
     for (auto& element : j.at("devices"))
     {
+        // Everything the device's registration is built from
+        std::string registration = std::string(REGISTRATION_VERSION) + (positioned ? "P" : "") + element.dump();
+
         const auto name = element.at("name").get<std::string>();
-        auto key = element.at("key").get<std::string>();
+        const auto key = str_toupper(element.at("key").get<std::string>());
+        if (shard_of(key, shardSettings.count) != shardSettings.index)
+        {
+            // Validated by the shard owning it
+            otherShards.keys.push_back(key);
+            BeaconIdentity identity;
+            if (parse_beacon_key(key, identity))
+            {
+                otherShards.beacons[key] = identity;
+            }
+            IdentityResolvingKey irk;
+            if (element.find("irk") != element.end() && parse_irk(element.at("irk").get<std::string>(), irk))
+            {
+                otherShards.irks[key] = irk;
+            }
+            continue;
+        }
+
+        BeaconIdentity identity;
+        if (key.compare(0, 8, "IBEACON:") == 0 || key.compare(0, 10, "EDDYSTONE:") == 0)
+        {
+            if (!parse_beacon_key(key, identity))
+            {
+                throw std::logic_error("Invalid beacon identity in device key " + key);
+            }
+            beacons[key] = identity;
+        }
+
+        if (element.find("irk") != element.end())
+        {
+            IdentityResolvingKey irk;
+            if (!parse_irk(element.at("irk").get<std::string>(), irk))
+            {
+                throw std::logic_error("Invalid identity resolving key for device " + key);
+            }
+            irks[key] = irk;
+        }
+
+        std::vector<SensorTemplate> sensors{presenceSensor};
+
+        if (element.find("template") != element.end())
+        {
+            const auto templateName = element.at("template").get<std::string>();
+            const auto signal = templates.find(templateName);
+            if (signal == templates.end())
+            {
+                throw std::logic_error("Unknown template '" + templateName + "' for device " + key);
+            }
+
+            addSignalSensors(signal->second, positioned, sensors);
+            signalTemplates[key] = signal->second;
+            registration += j.at("templates").at(templateName).dump();
+        }
+
+        if (element.find("decoder") != element.end())
+        {
+            const auto decoderName = element.at("decoder").get<std::string>();
+            const auto decoder = find_decoder(decoderName);
+            if (decoder == nullptr)
+            {
+                throw std::logic_error("Unknown advertisement decoder '" + decoderName + "' for device " + key);
+            }
+
+            for (gsize i = 0; i < decoder->sensor_count; ++i)
+            {
+                const auto& sensor = decoder->sensors[i];
+                sensors.emplace_back(sensor.name, sensor.reference, wolkabout::ReadingType::Name::GENERIC,
+                                     wolkabout::ReadingType::MeasurmentUnit::NUMERIC, sensor.description);
+            }
+            decoders[key] = decoder;
+        }
+
+        const bool hasGatt = element.find("gatt") != element.end();
+        const bool hasActuators = element.find("actuators") != element.end();
+        std::vector<ActuatorTemplate> actuators;
+
+        if (hasGatt || hasActuators)
+        {
+            const auto gatt = hasGatt ? element.at("gatt") : json::object();
+
+            GattDevice gattDevice;
+            gattDevice.key = key;
+            gattDevice.address = str_toupper(element.value("address", key));
+            gattDevice.adapter = element.value("adapter", adapters.front().adapter);
+            if (std::none_of(adapters.begin(), adapters.end(),
+                             [&](const AdapterZone& adapter) { return adapter.adapter == gattDevice.adapter; }))
+            {
+                throw std::logic_error("Unknown adapter " + gattDevice.adapter + " for device " + key);
+            }
+            gattDevice.notify = gatt.value("mode", std::string("poll")) == "notify";
+            gattDevice.period = gatt.value("period", interval);
+            if (gattDevice.period == 0)
+            {
+                throw std::logic_error("GATT poll period must be positive for device " + key);
+            }
+
+            if (hasGatt)
+            {
+                for (const auto& characteristicElement : gatt.at("characteristics"))
+                {
+                    const auto characteristic = parseCharacteristic(characteristicElement, key);
+                    sensors.emplace_back(characteristic.name, characteristic.reference,
+                                         wolkabout::ReadingType::Name::GENERIC,
+                                         wolkabout::ReadingType::MeasurmentUnit::NUMERIC, "");
+                    gattDevice.characteristics.push_back(characteristic);
+                }
+            }
+
+            if (hasActuators)
+            {
+                for (const auto& actuatorElement : element.at("actuators"))
+                {
+                    const auto actuator = parseCharacteristic(actuatorElement, key);
+                    actuators.emplace_back(actuator.name, actuator.reference, wolkabout::ReadingType::Name::GENERIC,
+                                           wolkabout::ReadingType::MeasurmentUnit::NUMERIC, "");
+                    gattDevice.actuators.push_back(actuator);
+                }
+            }
+
+            gattDevices.push_back(gattDevice);
+        }
+
+        devices.push_back(Device(name, key, DeviceTemplate{{}, sensors, {}, actuators}));
+        registrationHashes.push_back(registration_hash(registration));
+    }
+
+    ScanSettings scanSettings;
+    scanSettings.window = j.value("scanWindow", interval);
+    scanSettings.interval = j.value("scanInterval", 2 * scanSettings.window);
+    scanSettings.rssi_threshold = j.value("rssiThreshold", ADAPTER_RSSI_MIN);
+    scanSettings.absence_timeout = j.value("absenceTimeout", 0u);
+    if (!valid_scan_settings(scanSettings))
+    {
+        throw std::logic_error("Invalid scan settings");
+    }
+
+    AdmissionSettings admissionSettings = AdmissionControl::DEFAULT_SETTINGS;
+    admissionSettings.rate = j.value("admissionRate", admissionSettings.rate);
+    admissionSettings.burst = j.value("admissionBurst", admissionSettings.burst);
+    admissionSettings.unknown_cache = j.value("unknownCacheSize", admissionSettings.unknown_cache);
+    if (!valid_admission_settings(admissionSettings))
+    {
+        throw std::logic_error("Invalid admission settings");
+    }
+
+    EventSettings eventSettings = PresenceEvents::DEFAULT_SETTINGS;
+    eventSettings.enabled = j.value("presenceEvents", eventSettings.enabled);
+    eventSettings.spacing = j.value("eventSpacing", eventSettings.spacing);
+    eventSettings.rate = j.value("eventRate", eventSettings.rate);
+    eventSettings.burst = j.value("eventBurst", eventSettings.burst);
+    if (!valid_event_settings(eventSettings))
+    {
+        throw std::logic_error("Invalid presence event settings");
+    }
+
+    HistorySettings historySettings = PresenceHistory::DEFAULT_SETTINGS;
+    historySettings.resolution = j.value("historyResolution", historySettings.resolution);
+    historySettings.retention_days = j.value("historyDays", historySettings.retention_days);
+    if (!valid_history_settings(historySettings))
+    {
+        throw std::logic_error("Invalid presence history settings");
+    }
 
-        devices.push_back(Device(name, str_toupper(key), deviceTemplate1));
+    // The offline store keeps references of up to six characters, longer ones would be replayed truncated
+    if (!j.value("offlineStore", std::string()).empty())
+    {
+        for (const auto& gattDevice : gattDevices)
+        {
+            for (const auto& characteristic : gattDevice.characteristics)
+            {
+                if (characteristic.reference.size() > sizeof(StoredReading::reference))
+                {
+                    throw std::logic_error("Reference " + characteristic.reference + " of device " + gattDevice.key +
+                                           " is too long for the offline store");
+                }
+            }
+        }
+    }
+
+    // Every shard has its own module device
+    auto moduleKey = j.value("moduleKey", std::string());
+    if (!moduleKey.empty() && shardSettings.count > 1)
+    {
+        moduleKey += "-" + std::to_string(shardSettings.index);
+    }
+    for (const auto& device : devices)
+    {
+        if (!moduleKey.empty() && device.getKey() == moduleKey)
+        {
+            throw std::logic_error("Module key " + moduleKey + " is also used by a device");
+        }
     }
 
-    return DeviceConfiguration(localMqttUri, interval, devices, valueGenerator.value());
+    return DeviceConfiguration(localMqttUri, interval, devices, valueGenerator.value(), decoders, beacons, irks,
+                               gattDevices, j.value("gattConnections", DEFAULT_GATT_CONNECTIONS), moduleKey,
+                               scanSettings, signalTemplates, adapters, admissionSettings, eventSettings,
+                               shard_path(j.value("offlineStore", std::string()), shardSettings),
+                               j.value("offlineStoreSize", DEFAULT_OFFLINE_STORE_SIZE), protocol,
+                               j.value("advertisementMonitor", false),
+                               shard_path(j.value("presenceHistory", std::string()), shardSettings), historySettings,
+                               parseGroups(j, devices, moduleKey),
+                               shard_path(j.value("registrationCache", std::string()), shardSettings),
+                               registrationHashes, shardSettings, otherShards);
 }
 }    // namespace wolkabout
@@ -14,27 +14,76 @@
  * limitations under the License.
  */
 
+#include "AdvertisementDecoder.h"
+#include "BeaconIdentity.h"
+#include "DeviceRegistry.h"
+#include "Gatt.h"
+#include "GroupOccupancy.h"
+#include "IrkResolver.h"
+#include "PresenceEvents.h"
+#include "PresenceHistory.h"
+#include "RegistrationCache.h"
+#include "Scanner.h"
+#include "Shard.h"
 #include "core/model/DeviceTemplate.h"
 #include "model/Device.h"
 #include "utils.h"
 
+#include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace wolkabout
 {
+const char* const SCAN_INTERVAL_REFERENCE = "SI";
+const char* const SCAN_WINDOW_REFERENCE = "SW";
+const char* const RSSI_THRESHOLD_REFERENCE = "RSSI";
+const char* const ABSENCE_TIMEOUT_REFERENCE = "AT";
+const char* const ADMITTED_REFERENCE = "SA";
+const char* const THROTTLED_REFERENCE = "ST";
+const char* const UNKNOWN_REFERENCE = "SU";
+const char* const OCCUPANCY_REFERENCE = "O";
+
 enum class ValueGenerator
 {
     RANDOM = 0,
     INCEREMENTAL
 };
 
+enum class PayloadProtocol
+{
+    JSON = 0,
+    CBOR
+};
+
+/**
+ * Devices of the configuration owned by other shards, with the identities
+ * their sightings resolve through.
+ */
+struct OtherShardDevices
+{
+    std::vector<std::string> keys;
+    std::map<std::string, BeaconIdentity> beacons;
+    std::map<std::string, IdentityResolvingKey> irks;
+};
+
 class DeviceConfiguration
 {
 public:
     DeviceConfiguration() = default;
     DeviceConfiguration(std::string localMqttUri, unsigned interval, std::vector<wolkabout::Device> devices,
-                        ValueGenerator generator);
+                        ValueGenerator generator, std::map<std::string, const AdvertisementDecoder*> decoders,
+                        std::map<std::string, BeaconIdentity> beacons,
+                        std::map<std::string, IdentityResolvingKey> irks, std::vector<GattDevice> gattDevices,
+                        unsigned gattConnections, std::string moduleKey, ScanSettings scanSettings,
+                        std::map<std::string, SignalTemplate> signalTemplates, std::vector<AdapterZone> adapters,
+                        AdmissionSettings admissionSettings, EventSettings eventSettings, std::string offlineStore,
+                        unsigned offlineStoreSize, PayloadProtocol protocol, bool advertisementMonitor,
+                        std::string presenceHistory, HistorySettings historySettings,
+                        std::vector<DeviceGroup> groups, std::string registrationCache,
+                        std::vector<guint64> registrationHashes, ShardSettings shard,
+                        OtherShardDevices otherShards);
 
     const std::string& getLocalMqttUri() const;
 
@@ -44,7 +93,111 @@ public:
 
     const std::vector<wolkabout::Device>& getDevices() const;
 
-    static wolkabout::DeviceConfiguration fromJson(const std::string& deviceConfigurationFile);
+    /**
+     * Position of the device with the given key in `getDevices()`, or
+     * `NO_DEVICE`. Looked up in a hashed index built with the configuration.
+     */
+    size_t findDevice(const std::string& key) const;
+
+    static const size_t NO_DEVICE;
+
+    const std::map<std::string, const AdvertisementDecoder*>& getDecoders() const;
+
+    const std::map<std::string, BeaconIdentity>& getBeacons() const;
+
+    const std::map<std::string, IdentityResolvingKey>& getIrks() const;
+
+    const std::vector<GattDevice>& getGattDevices() const;
+
+    unsigned getGattConnections() const;
+
+    const std::string& getModuleKey() const;
+
+    /**
+     * Device through which the scan settings are exposed as configuration and
+     * admission counters are reported. Only meaningful when a module key is
+     * configured.
+     */
+    wolkabout::Device getModuleDevice() const;
+
+    const ScanSettings& getScanSettings() const;
+
+    const std::map<std::string, SignalTemplate>& getSignalTemplates() const;
+
+    const std::vector<AdapterZone>& getAdapters() const;
+
+    const AdmissionSettings& getAdmissionSettings() const;
+
+    const EventSettings& getEventSettings() const;
+
+    /**
+     * Path of the file readings are stored in while the gateway is unreachable,
+     * empty when readings are not stored.
+     */
+    const std::string& getOfflineStore() const;
+
+    /**
+     * Size of the offline store in KiB.
+     */
+    unsigned getOfflineStoreSize() const;
+
+    PayloadProtocol getProtocol() const;
+
+    /**
+     * Whether presence is left to BlueZ advertisement monitors where the
+     * configuration allows it.
+     */
+    bool getAdvertisementMonitor() const;
+
+    /**
+     * Path of the presence history file, empty when no history is kept.
+     */
+    const std::string& getPresenceHistory() const;
+
+    const HistorySettings& getHistorySettings() const;
+
+    const std::vector<DeviceGroup>& getGroups() const;
+
+    /**
+     * Position of the group with the given key in `getGroups()`, or
+     * `NO_DEVICE`.
+     */
+    size_t findGroup(const std::string& key) const;
+
+    /**
+     * Path of the registration cache, empty when every device is registered
+     * before connecting.
+     */
+    const std::string& getRegistrationCache() const;
+
+    /**
+     * Hash of the configuration the device's registration is built from.
+     */
+    guint64 getRegistrationHash(size_t device) const;
+
+    /**
+     * Shard of the devices this instance owns. State file paths and the
+     * module key already carry the shard's suffix.
+     */
+    const ShardSettings& getShard() const;
+
+    /**
+     * Devices the other shards own, so their sightings can be told apart
+     * from unknown neighbours.
+     */
+    const OtherShardDevices& getOtherShards() const;
+
+    /**
+     * Virtual device through which the group's occupancy is published.
+     */
+    wolkabout::Device getGroupDevice(const DeviceGroup& group) const;
+
+    /**
+     * `shard`, as "<index>/<count>", overrides the configured shard when not
+     * empty.
+     */
+    static wolkabout::DeviceConfiguration fromJson(const std::string& deviceConfigurationFile,
+                                                   const std::string& shard = "");
 
 private:
     std::string m_localMqttUri;
@@ -53,6 +206,54 @@ private:
 
     std::vector<wolkabout::Device> m_devices;
 
+    std::unordered_map<std::string, size_t> m_deviceIndex;
+
     ValueGenerator m_valueGenerator;
+
+    std::map<std::string, const AdvertisementDecoder*> m_decoders;
+
+    std::map<std::string, BeaconIdentity> m_beacons;
+
+    std::map<std::string, IdentityResolvingKey> m_irks;
+
+    std::vector<GattDevice> m_gattDevices;
+
+    unsigned m_gattConnections;
+
+    std::string m_moduleKey;
+
+    ScanSettings m_scanSettings;
+
+    std::map<std::string, SignalTemplate> m_signalTemplates;
+
+    std::vector<AdapterZone> m_adapters;
+
+    AdmissionSettings m_admissionSettings;
+
+    EventSettings m_eventSettings;
+
+    std::string m_offlineStore;
+
+    unsigned m_offlineStoreSize;
+
+    PayloadProtocol m_protocol;
+
+    bool m_advertisementMonitor;
+
+    std::string m_presenceHistory;
+
+    HistorySettings m_historySettings;
+
+    std::vector<DeviceGroup> m_groups;
+
+    std::unordered_map<std::string, size_t> m_groupIndex;
+
+    std::string m_registrationCache;
+
+    std::vector<guint64> m_registrationHashes;
+
+    ShardSettings m_shard;
+
+    OtherShardDevices m_otherShards;
 };
 }    // namespace wolkabout
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CborProtocol.h"
+#include "core/model/Message.h"
+#include "core/model/SensorReading.h"
+#include "core/protocol/json/JsonProtocol.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Workload
+{
+    const char* name;
+    std::vector<std::shared_ptr<wolkabout::SensorReading>> readings;
+};
+
+void run(const wolkabout::DataProtocol& protocol, const char* protocolName, const Workload& workload,
+         unsigned devices, unsigned iterations)
+{
+    std::size_t bytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned device = 0; device < devices; ++device)
+        {
+            const auto message = protocol.makeMessage("device" + std::to_string(device), workload.readings, ",");
+            bytes += message->getContent().size();
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double readings = static_cast<double>(workload.readings.size()) * devices * iterations;
+    const double nanoseconds =
+      static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    std::cout << std::left << std::setw(10) << workload.name << std::setw(16) << protocolName << std::right
+              << std::fixed << std::setprecision(1) << std::setw(12) << nanoseconds / readings << std::setw(12)
+              << static_cast<double>(bytes) / readings << "\n";
+}
+}    // namespace
+
+int main(int argc, char** argv)
+{
+    const unsigned devices = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 1000;
+    const unsigned iterations = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 100;
+
+    Workload presence{"presence", {}};
+    presence.readings.push_back(std::make_shared<wolkabout::SensorReading>("1", "P", 1546300800000ULL));
+
+    Workload signal{"signal", {}};
+    signal.readings.push_back(std::make_shared<wolkabout::SensorReading>("1", "P", 1546300800000ULL));
+    signal.readings.push_back(std::make_shared<wolkabout::SensorReading>("-71.25", "RSSI", 1546300800000ULL));
+    signal.readings.push_back(std::make_shared<wolkabout::SensorReading>("3.162278", "D", 1546300800000ULL));
+    signal.readings.push_back(std::make_shared<wolkabout::SensorReading>("12", "S", 1546300800000ULL));
+
+    wolkabout::JsonProtocol json;
+    wolkabout::CborProtocol cbor;
+
+    std::cout << devices << " devices, " << iterations << " iterations\n";
+    std::cout << std::left << std::setw(10) << "workload" << std::setw(16) << "protocol" << std::right
+              << std::setw(12) << "ns/reading" << std::setw(12) << "B/reading" << "\n";
+    for (const auto& workload : {presence, signal})
+    {
+        run(json, "JSON_PROTOCOL", workload, devices, iterations);
+        run(cbor, "CBOR_PROTOCOL", workload, devices, iterations);
+    }
+
+    return 0;
+}
@@ -2,7 +2,7 @@
 
 namespace wolkabout
 {
-Adapter::Adapter()
+Adapter::Adapter(const std::string& name) : path("/org/bluez/" + name)
 {
     is_scanning = FALSE;
 }
@@ -12,7 +12,7 @@ int Adapter::call_method(const char* method, GVariant* param)
     GVariant* result;
     GError* error = NULL;
 
-    result = g_dbus_connection_call_sync(s_connection, "org.bluez", "/org/bluez/hci0", "org.bluez.Adapter1", method,
+    result = g_dbus_connection_call_sync(Bus::connection(), "org.bluez", path.c_str(), "org.bluez.Adapter1", method,
                                          param, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
     if (error != NULL)
         return 1;
@@ -27,7 +27,7 @@ int Adapter::set_property(const char* prop, GVariant* value)
     GError* error = NULL;
 
     result = g_dbus_connection_call_sync(
-      s_connection, "org.bluez", "/org/bluez/hci0", "org.freedesktop.DBus.Properties", "Set",
+      Bus::connection(), "org.bluez", path.c_str(), "org.freedesktop.DBus.Properties", "Set",
       g_variant_new("(ssv)", "org.bluez.Adapter1", prop, value), NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
     if (error != NULL)
         return 1;
@@ -36,6 +36,11 @@ int Adapter::set_property(const char* prop, GVariant* value)
     return 0;
 }
 
+const std::string& Adapter::object_path() const
+{
+    return path;
+}
+
 void Adapter::signal_changed(GDBusConnection* conn, const gchar* sender, const gchar* path, const gchar* interface,
                              const gchar* signal, GVariant* params, void* userdata)
 {
@@ -87,7 +92,7 @@ void Adapter::signal_changed(GDBusConnection* conn, const gchar* sender, const g
 
 int Adapter::subscribe_adapter_changed()
 {
-    return g_dbus_connection_signal_subscribe(s_connection, "org.bluez", "org.freedesktop.DBus.Properties",
+    return g_dbus_connection_signal_subscribe(Bus::connection(), "org.bluez", "org.freedesktop.DBus.Properties",
                                               "PropertiesChanged", NULL, "org.bluez.Adapter1", G_DBUS_SIGNAL_FLAGS_NONE,
                                               Adapter::signal_changed, NULL, NULL);
 }
@@ -95,22 +100,20 @@ int Adapter::subscribe_adapter_changed()
 int Adapter::subscribe_device_added(void (*f)(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
                                               GVariant*, gpointer))
 {
-    return g_dbus_connection_signal_subscribe(s_connection, "org.bluez", "org.freedesktop.DBus.ObjectManager",
-                                              "InterfacesAdded", NULL, NULL, G_DBUS_SIGNAL_FLAGS_NONE, (*f), s_loop,
-                                              NULL);
+    // Only objects of this adapter, signals are delivered to the calling thread's main context
+    const std::string objects = path + "/";
+    return g_dbus_connection_signal_subscribe(Bus::connection(), "org.bluez", "org.freedesktop.DBus.ObjectManager",
+                                              "InterfacesAdded", NULL, objects.c_str(),
+                                              G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_PATH, (*f), this, NULL);
 }
 
 int Adapter::subscribe_device_removed(void (*f)(GDBusConnection*, const gchar*, const gchar*, const gchar*,
                                                 const gchar*, GVariant*, gpointer))
 {
-    return g_dbus_connection_signal_subscribe(s_connection, "org.bluez", "org.freedesktop.DBus.ObjectManager",
-                                              "InterfacesRemoved", NULL, NULL, G_DBUS_SIGNAL_FLAGS_NONE, (*f), s_loop,
-                                              NULL);
-}
-
-void Adapter::run_loop()
-{
-    g_main_loop_run(s_loop);
+    const std::string objects = path + "/";
+    return g_dbus_connection_signal_subscribe(Bus::connection(), "org.bluez", "org.freedesktop.DBus.ObjectManager",
+                                              "InterfacesRemoved", NULL, objects.c_str(),
+                                              G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_PATH, (*f), this, NULL);
 }
 
 int Adapter::remove_device(const char* device)
@@ -135,6 +138,16 @@ int Adapter::stop_scan()
     return Adapter::call_method("StopDiscovery", NULL);
 }
 
+int Adapter::set_discovery_filter(int rssi)
+{
+    GVariantBuilder filter;
+    g_variant_builder_init(&filter, G_VARIANT_TYPE("a{sv}"));
+    if (rssi > ADAPTER_RSSI_MIN)
+        g_variant_builder_add(&filter, "{sv}", "RSSI", g_variant_new_int16(static_cast<gint16>(rssi)));
+
+    return Adapter::call_method("SetDiscoveryFilter", g_variant_new("(a{sv})", &filter));
+}
+
 bool Adapter::scanning()
 {
     return is_scanning;
@@ -1,25 +1,29 @@
 #ifndef ADAPTER_H
 #define ADAPTER_H
 
+#include "Bus.h"
 #include "utils.h"
 
 #include <gio/gio.h>
 #include <glib.h>
 #include <iostream>
+#include <string>
+
+#define ADAPTER_RSSI_MIN -127
+#define ADAPTER_RSSI_MAX 20
 
 namespace wolkabout
 {
-static GDBusConnection* s_connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, NULL);
-static GMainLoop* s_loop = g_main_loop_new(NULL, FALSE);
-
 class Adapter
 {
 public:
-    Adapter();
+    explicit Adapter(const std::string& name = "hci0");
+
+    int call_method(const char* method, GVariant* param);
 
-    static int call_method(const char* method, GVariant* param);
+    int set_property(const char* prop, GVariant* value);
 
-    static int set_property(const char* prop, GVariant* value);
+    const std::string& object_path() const;
 
     int power_on();
 
@@ -29,18 +33,30 @@ public:
 
     int stop_scan();
 
+    /**
+     * Limits discovery to advertisements received at or above `rssi` dBm.
+     * Thresholds at or below ADAPTER_RSSI_MIN clear the filter. Applies from
+     * the next StartDiscovery.
+     */
+    int set_discovery_filter(int rssi);
+
     int subscribe_adapter_changed();
 
+    /**
+     * Device signals are limited to this adapter's objects and are dispatched
+     * in the caller's thread-default main context.
+     * Handlers receive the adapter as user data.
+     */
     int subscribe_device_added(void (*f)(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
                                          GVariant*, gpointer));
     int subscribe_device_removed(void (*f)(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
                                            GVariant*, gpointer));
 
-    void run_loop();
-
     bool scanning();
 
 private:
+    std::string path;
+
     bool is_scanning;
 
     static void signal_changed(GDBusConnection* conn, const gchar* sender, const gchar* path, const gchar* interface,
@@ -0,0 +1,170 @@
+#include "AdapterWorker.h"
+#include "core/utilities/Logger.h"
+
+namespace wolkabout
+{
+AdapterWorker::AdapterWorker(Adapter& worker_adapter, SignalHandler added, SignalHandler removed,
+                             SignalHandler changed)
+: adapter(worker_adapter)
+, added_handler(added)
+, removed_handler(removed)
+, changed_handler(changed)
+, context(g_main_context_new())
+, loop(g_main_loop_new(context, FALSE))
+, scan_requested(false)
+, is_monitored(false)
+{
+}
+
+AdapterWorker::~AdapterWorker()
+{
+    if (thread.joinable())
+    {
+        invoke([this] { g_main_loop_quit(loop); });
+        thread.join();
+    }
+    g_main_loop_unref(loop);
+    g_main_context_unref(context);
+}
+
+void AdapterWorker::start()
+{
+    thread = std::thread(&AdapterWorker::run, this);
+}
+
+void AdapterWorker::run()
+{
+    g_main_context_push_thread_default(context);
+    subscribe();
+    g_main_loop_run(loop);
+
+    for (int subscription : subscriptions)
+        g_dbus_connection_signal_unsubscribe(Bus::connection(), static_cast<guint>(subscription));
+    g_main_context_pop_thread_default(context);
+}
+
+void AdapterWorker::subscribe()
+{
+    for (int subscription : subscriptions)
+        g_dbus_connection_signal_unsubscribe(Bus::connection(), static_cast<guint>(subscription));
+    subscriptions.clear();
+
+    subscriptions.push_back(adapter.subscribe_device_added(added_handler));
+    subscriptions.push_back(adapter.subscribe_device_removed(removed_handler));
+}
+
+int AdapterWorker::subscribe_device_changed(const std::vector<std::unique_ptr<AdapterWorker>>& workers)
+{
+    // PropertiesChanged cannot be matched by a path prefix, one subscription serves all adapters
+    return g_dbus_connection_signal_subscribe(
+      Bus::connection(), "org.bluez", "org.freedesktop.DBus.Properties", "PropertiesChanged", NULL,
+      "org.bluez.Device1", G_DBUS_SIGNAL_FLAGS_NONE, AdapterWorker::route_changed,
+      const_cast<std::vector<std::unique_ptr<AdapterWorker>>*>(&workers), NULL);
+}
+
+void AdapterWorker::route_changed(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                  const gchar* interface, const gchar* signal, GVariant* parameters,
+                                  gpointer user_data)
+{
+    (void)connection;
+
+    const auto& workers = *static_cast<const std::vector<std::unique_ptr<AdapterWorker>>*>(user_data);
+    for (const auto& worker : workers)
+    {
+        const std::string& adapter_path = worker->adapter.object_path();
+        if (!g_str_has_prefix(path, adapter_path.c_str()) || path[adapter_path.size()] != '/')
+            continue;
+
+        if (worker->changed_handler == NULL)
+            return;
+
+        AdapterWorker* target = worker.get();
+        std::shared_ptr<GVariant> changed(g_variant_ref(parameters), g_variant_unref);
+        std::string changed_sender = sender;
+        std::string changed_path = path;
+        std::string changed_interface = interface;
+        std::string changed_signal = signal;
+        target->invoke([target, changed, changed_sender, changed_path, changed_interface, changed_signal] {
+            target->changed_handler(Bus::connection(), changed_sender.c_str(), changed_path.c_str(),
+                                    changed_interface.c_str(), changed_signal.c_str(), changed.get(),
+                                    &target->adapter);
+        });
+        return;
+    }
+}
+
+void AdapterWorker::resubscribe()
+{
+    invoke([this] { subscribe(); });
+}
+
+void AdapterWorker::start_scan()
+{
+    scan_requested = true;
+    if (is_monitored)
+        return;
+
+    invoke([this] {
+        if (adapter.start_scan())
+            LOG(WARN) << "Unable to start discovery on " << adapter.object_path();
+    });
+}
+
+void AdapterWorker::stop_scan()
+{
+    scan_requested = false;
+    if (is_monitored)
+        return;
+
+    invoke([this] {
+        if (adapter.stop_scan())
+            LOG(WARN) << "Unable to stop discovery on " << adapter.object_path();
+    });
+}
+
+void AdapterWorker::set_monitored(bool monitored)
+{
+    if (monitored == is_monitored)
+        return;
+
+    // Discovery follows the requested state again once monitoring stops
+    const bool requested = scan_requested;
+    if (monitored && requested)
+        stop_scan();
+    is_monitored = monitored;
+    if (!monitored && requested)
+        start_scan();
+    scan_requested = requested;
+}
+
+void AdapterWorker::set_discovery_filter(int rssi)
+{
+    invoke([this, rssi] {
+        if (adapter.set_discovery_filter(rssi))
+            LOG(WARN) << "Unable to set the discovery filter on " << adapter.object_path();
+    });
+}
+
+void AdapterWorker::remove_device(const std::string& object)
+{
+    invoke([this, object] { adapter.remove_device(object.c_str()); });
+}
+
+void AdapterWorker::invoke(std::function<void()> f)
+{
+    g_main_context_invoke_full(context, G_PRIORITY_DEFAULT, AdapterWorker::call,
+                               new std::function<void()>(std::move(f)), AdapterWorker::free_call);
+}
+
+gboolean AdapterWorker::call(gpointer user_data)
+{
+    (*static_cast<std::function<void()>*>(user_data))();
+    return G_SOURCE_REMOVE;
+}
+
+void AdapterWorker::free_call(gpointer user_data)
+{
+    delete static_cast<std::function<void()>*>(user_data);
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,106 @@
+#ifndef ADAPTERWORKER_H
+#define ADAPTERWORKER_H
+
+#include "Adapter.h"
+
+#include <functional>
+#include <gio/gio.h>
+#include <glib.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wolkabout
+{
+typedef void (*SignalHandler)(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*, GVariant*,
+                              gpointer);
+
+/**
+ * Runs the device signals and scan control of one adapter on a thread with
+ * its own main context, so advertisements heard by several adapters are
+ * decoded in parallel. Scan control requests return immediately and are
+ * carried out in order on the worker, failures are logged there. Property
+ * changes of devices are subscribed to once for all workers, see
+ * subscribe_device_changed.
+ */
+class AdapterWorker
+{
+public:
+    /**
+     * `changed` handles the property changes routed to this worker, it may be
+     * NULL when RSSI updates are not needed.
+     */
+    AdapterWorker(Adapter& adapter, SignalHandler added, SignalHandler removed, SignalHandler changed);
+
+    ~AdapterWorker();
+
+    AdapterWorker(const AdapterWorker&) = delete;
+    AdapterWorker& operator=(const AdapterWorker&) = delete;
+
+    void start();
+
+    /**
+     * Subscribes in the caller's main context to the property changes of all
+     * devices and hands each to the worker of the adapter that owns the
+     * device, which runs its `changed` handler with the adapter as user data.
+     * The workers must outlive the subscription.
+     */
+    static int subscribe_device_changed(const std::vector<std::unique_ptr<AdapterWorker>>& workers);
+
+    /**
+     * Renews the signal subscriptions, after bluetoothd restarted.
+     */
+    void resubscribe();
+
+    void start_scan();
+
+    void stop_scan();
+
+    /**
+     * The scan state last requested, only used from the main loop.
+     */
+    bool scanning() const { return scan_requested; }
+
+    /**
+     * While an advertisement monitor is active on the adapter discovery is
+     * stopped, scan requests are only recorded and take effect when it is
+     * released. Only used from the main loop.
+     */
+    void set_monitored(bool monitored);
+
+    void set_discovery_filter(int rssi);
+
+    void remove_device(const std::string& object);
+
+private:
+    void run();
+
+    void invoke(std::function<void()> f);
+
+    static gboolean call(gpointer user_data);
+    static void free_call(gpointer user_data);
+
+    static void route_changed(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                              const gchar* interface, const gchar* signal, GVariant* parameters, gpointer user_data);
+
+    void subscribe();
+
+    Adapter& adapter;
+    SignalHandler added_handler;
+    SignalHandler removed_handler;
+    SignalHandler changed_handler;
+
+    GMainContext* context;
+    GMainLoop* loop;
+    std::thread thread;
+
+    bool scan_requested;
+    bool is_monitored;
+
+    // Only touched on the worker
+    std::vector<int> subscriptions;
+};
+
+}    // namespace wolkabout
+#endif
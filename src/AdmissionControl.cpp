@@ -0,0 +1,67 @@
+#include "AdmissionControl.h"
+
+namespace wolkabout
+{
+const AdmissionSettings AdmissionControl::DEFAULT_SETTINGS = {200, 400, 4096};
+
+bool valid_admission_settings(const AdmissionSettings& settings)
+{
+    return settings.rate > 0 && settings.burst >= 1 && settings.unknown_cache > 0;
+}
+
+AdmissionControl::AdmissionControl(const AdmissionSettings& admission_settings)
+: settings(admission_settings), counters{0, 0, 0, 0}
+{
+    set_adapters(1);
+}
+
+void AdmissionControl::set_adapters(gsize count)
+{
+    buckets.assign(count, TokenBucket(settings.rate, settings.burst));
+}
+
+bool AdmissionControl::known_unknown(guint64 address)
+{
+    const auto it = unknown.find(address);
+    if (it == unknown.end())
+        return false;
+
+    unknown_order.splice(unknown_order.begin(), unknown_order, it->second);
+    ++counters.ignored;
+    return true;
+}
+
+bool AdmissionControl::try_admit(gsize adapter)
+{
+    if (!buckets[adapter < buckets.size() ? adapter : 0].take())
+    {
+        ++counters.throttled;
+        return false;
+    }
+    return true;
+}
+
+void AdmissionControl::remember_unknown(guint64 address)
+{
+    if (unknown.find(address) != unknown.end())
+        return;
+
+    if (unknown.size() >= settings.unknown_cache)
+    {
+        unknown.erase(unknown_order.back());
+        unknown_order.pop_back();
+    }
+
+    ++counters.unknown;
+    unknown_order.push_front(address);
+    unknown[address] = unknown_order.begin();
+}
+
+AdmissionControl::Counters AdmissionControl::collect()
+{
+    const Counters collected = counters;
+    counters = Counters{0, 0, 0, 0};
+    return collected;
+}
+
+}    // namespace wolkabout
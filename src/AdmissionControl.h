@@ -0,0 +1,85 @@
+#ifndef ADMISSIONCONTROL_H
+#define ADMISSIONCONTROL_H
+
+#include "TokenBucket.h"
+
+#include <glib.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * `rate` and `burst` size the per adapter token bucket for sightings of
+ * unconfigured devices, `unknown_cache` the number of unknown addresses
+ * remembered.
+ */
+struct AdmissionSettings
+{
+    double rate;
+    double burst;
+    gsize unknown_cache;
+};
+
+bool valid_admission_settings(const AdmissionSettings& settings);
+
+/**
+ * Bounds the work spent on sightings of devices that are not configured.
+ * Configured devices are always admitted. Unknown addresses are remembered
+ * in a bounded LRU so repeated advertisements are dropped after a single
+ * lookup, and new ones are rate limited per adapter by a token bucket, so a
+ * flood of random addresses is shed before it reaches the expensive
+ * resolution steps.
+ */
+class AdmissionControl
+{
+public:
+    struct Counters
+    {
+        guint64 admitted;
+        guint64 throttled;
+        guint64 ignored;
+        guint64 unknown;
+    };
+
+    static const AdmissionSettings DEFAULT_SETTINGS;
+
+    explicit AdmissionControl(const AdmissionSettings& admission_settings = DEFAULT_SETTINGS);
+
+    void set_adapters(gsize count);
+
+    void admit() { ++counters.admitted; }
+
+    /**
+     * True when the address is remembered as unknown, in which case the
+     * sighting is dropped.
+     */
+    bool known_unknown(guint64 address);
+
+    /**
+     * Takes a token from the adapter's bucket, dropping the sighting when it
+     * is empty.
+     */
+    bool try_admit(gsize adapter);
+
+    void remember_unknown(guint64 address);
+
+    /**
+     * Returns the counters accumulated since the last call and resets them.
+     */
+    Counters collect();
+
+private:
+    AdmissionSettings settings;
+
+    std::vector<TokenBucket> buckets;
+
+    std::list<guint64> unknown_order;
+    std::unordered_map<guint64, std::list<guint64>::iterator> unknown;
+
+    Counters counters;
+};
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,100 @@
+#include "AdvertisementDecoder.h"
+#include "AdvertisementDecoders.h"
+
+namespace wolkabout
+{
+namespace
+{
+template <typename Decoder> bool decode_with(const guint8* data, gsize size, const ReadingSink& sink)
+{
+    return Decoder::decode(data, size, sink);
+}
+
+const DecoderSensor ruuvi_sensors[] = {
+  {"Temperature", "T", "Temperature in degrees Celsius"},
+  {"Humidity", "H", "Relative humidity in percent"},
+  {"Pressure", "PR", "Atmospheric pressure in hPa"},
+  {"Acceleration X", "AX", "Acceleration on the X axis in g"},
+  {"Acceleration Y", "AY", "Acceleration on the Y axis in g"},
+  {"Acceleration Z", "AZ", "Acceleration on the Z axis in g"},
+  {"Battery voltage", "BV", "Battery voltage in mV"},
+  {"Movement counter", "MC", "Number of detected movements"}};
+
+const DecoderSensor eddystone_tlm_sensors[] = {{"Battery voltage", "BV", "Battery voltage in mV"},
+                                               {"Temperature", "T", "Temperature in degrees Celsius"},
+                                               {"Uptime", "UP", "Time since power-up in seconds"}};
+
+const DecoderSensor atc_sensors[] = {{"Temperature", "T", "Temperature in degrees Celsius"},
+                                     {"Humidity", "H", "Relative humidity in percent"},
+                                     {"Battery", "B", "Battery level in percent"},
+                                     {"Battery voltage", "BV", "Battery voltage in mV"}};
+
+const DecoderSensor battery_sensors[] = {{"Battery", "B", "Battery level in percent"}};
+
+const AdvertisementDecoder s_decoders[] = {
+  {"ruuvi", AdvertisementSource::MANUFACTURER_DATA, 0x0499, nullptr, decode_with<decoders::RuuviRawV2>,
+   ruuvi_sensors, G_N_ELEMENTS(ruuvi_sensors)},
+  {"eddystone_tlm", AdvertisementSource::SERVICE_DATA, 0, "0000feaa-0000-1000-8000-00805f9b34fb",
+   decode_with<decoders::EddystoneTlm>, eddystone_tlm_sensors, G_N_ELEMENTS(eddystone_tlm_sensors)},
+  {"atc", AdvertisementSource::SERVICE_DATA, 0, "0000181a-0000-1000-8000-00805f9b34fb", decode_with<decoders::Atc>,
+   atc_sensors, G_N_ELEMENTS(atc_sensors)},
+  {"battery", AdvertisementSource::SERVICE_DATA, 0, "0000180f-0000-1000-8000-00805f9b34fb",
+   decode_with<decoders::BatteryLevel>, battery_sensors, G_N_ELEMENTS(battery_sensors)}};
+}    // namespace
+
+const AdvertisementDecoder* find_decoder(const std::string& name)
+{
+    for (const auto& decoder : s_decoders)
+    {
+        if (name == decoder.name)
+            return &decoder;
+    }
+    return nullptr;
+}
+
+bool decode_advertisement(const AdvertisementDecoder& decoder, GVariant* manufacturer_data, GVariant* service_data,
+                          const ReadingSink& sink)
+{
+    GVariantIter i;
+    GVariant* payload;
+    bool decoded = false;
+
+    if (decoder.source == AdvertisementSource::MANUFACTURER_DATA)
+    {
+        if (manufacturer_data == NULL)
+            return false;
+
+        guint16 company_id;
+        g_variant_iter_init(&i, manufacturer_data);
+        while (!decoded && g_variant_iter_next(&i, "{qv}", &company_id, &payload))
+        {
+            if (company_id == decoder.company_id)
+            {
+                gsize size;
+                const guint8* data = static_cast<const guint8*>(g_variant_get_fixed_array(payload, &size, 1));
+                decoded = decoder.decode(data, size, sink);
+            }
+            g_variant_unref(payload);
+        }
+        return decoded;
+    }
+
+    if (service_data == NULL)
+        return false;
+
+    const gchar* uuid;
+    g_variant_iter_init(&i, service_data);
+    while (!decoded && g_variant_iter_next(&i, "{&sv}", &uuid, &payload))
+    {
+        if (!g_ascii_strcasecmp(uuid, decoder.service_uuid))
+        {
+            gsize size;
+            const guint8* data = static_cast<const guint8*>(g_variant_get_fixed_array(payload, &size, 1));
+            decoded = decoder.decode(data, size, sink);
+        }
+        g_variant_unref(payload);
+    }
+    return decoded;
+}
+
+}    // namespace wolkabout
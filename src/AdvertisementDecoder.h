@@ -0,0 +1,65 @@
+#ifndef ADVERTISEMENTDECODER_H
+#define ADVERTISEMENTDECODER_H
+
+#include "ReadingOutlet.h"
+
+#include <glib.h>
+#include <string>
+
+namespace wolkabout
+{
+enum class AdvertisementSource
+{
+    MANUFACTURER_DATA,
+    SERVICE_DATA
+};
+
+struct DecoderSensor
+{
+    const char* name;
+    const char* reference;
+    const char* description;
+};
+
+/**
+ * Forwards decoded values as sensor readings of the device the advertisement
+ * was resolved to. Value type is preserved so integers are not published as
+ * floating point values.
+ */
+class ReadingSink
+{
+public:
+    ReadingSink(ReadingOutlet& reading_outlet, const std::string& device_key) : outlet(reading_outlet), key(device_key)
+    {
+    }
+
+    template <typename T> void operator()(const char* reference, T value) const { outlet.add(key, reference, value); }
+
+private:
+    ReadingOutlet& outlet;
+    const std::string& key;
+};
+
+/**
+ * Describes one payload format. `decode` points to the compile time
+ * specialisation of the format for ReadingSink and receives the payload bytes
+ * as they are stored in the D-Bus message, without copying.
+ */
+struct AdvertisementDecoder
+{
+    const char* name;
+    AdvertisementSource source;
+    guint16 company_id;
+    const char* service_uuid;
+    bool (*decode)(const guint8* data, gsize size, const ReadingSink& sink);
+    const DecoderSensor* sensors;
+    gsize sensor_count;
+};
+
+const AdvertisementDecoder* find_decoder(const std::string& name);
+
+bool decode_advertisement(const AdvertisementDecoder& decoder, GVariant* manufacturer_data, GVariant* service_data,
+                          const ReadingSink& sink);
+
+}    // namespace wolkabout
+#endif
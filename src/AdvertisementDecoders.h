@@ -0,0 +1,150 @@
+#ifndef ADVERTISEMENTDECODERS_H
+#define ADVERTISEMENTDECODERS_H
+
+#include <glib.h>
+
+namespace wolkabout
+{
+namespace decoders
+{
+inline gint16 int16_be(const guint8* p)
+{
+    return static_cast<gint16>((p[0] << 8) | p[1]);
+}
+
+inline guint16 uint16_be(const guint8* p)
+{
+    return static_cast<guint16>((p[0] << 8) | p[1]);
+}
+
+inline gint16 int16_le(const guint8* p)
+{
+    return static_cast<gint16>((p[1] << 8) | p[0]);
+}
+
+inline guint16 uint16_le(const guint8* p)
+{
+    return static_cast<guint16>((p[1] << 8) | p[0]);
+}
+
+inline guint32 uint32_be(const guint8* p)
+{
+    return (static_cast<guint32>(p[0]) << 24) | (static_cast<guint32>(p[1]) << 16) |
+           (static_cast<guint32>(p[2]) << 8) | p[3];
+}
+
+/**
+ * RuuviTag data format 5 (RAWv2), manufacturer data of company 0x0499.
+ */
+struct RuuviRawV2
+{
+    template <typename Sink> static bool decode(const guint8* data, gsize size, const Sink& sink)
+    {
+        if (size < 18 || data[0] != 0x05)
+            return false;
+
+        const gint16 temperature = int16_be(data + 1);
+        if (temperature != G_MININT16)
+            sink("T", temperature * 0.005);
+
+        const guint16 humidity = uint16_be(data + 3);
+        if (humidity != G_MAXUINT16)
+            sink("H", humidity * 0.0025);
+
+        const guint16 pressure = uint16_be(data + 5);
+        if (pressure != G_MAXUINT16)
+            sink("PR", (pressure + 50000) / 100.0);
+
+        const gint16 acceleration_x = int16_be(data + 7);
+        const gint16 acceleration_y = int16_be(data + 9);
+        const gint16 acceleration_z = int16_be(data + 11);
+        if (acceleration_x != G_MININT16)
+            sink("AX", acceleration_x / 1000.0);
+        if (acceleration_y != G_MININT16)
+            sink("AY", acceleration_y / 1000.0);
+        if (acceleration_z != G_MININT16)
+            sink("AZ", acceleration_z / 1000.0);
+
+        const guint16 battery = static_cast<guint16>(uint16_be(data + 13) >> 5);
+        if (battery != 0x07FF)
+            sink("BV", battery + 1600);
+
+        if (data[15] != 0xFF)
+            sink("MC", static_cast<int>(data[15]));
+
+        return true;
+    }
+};
+
+/**
+ * Eddystone TLM frame, service data of UUID 0xFEAA.
+ */
+struct EddystoneTlm
+{
+    template <typename Sink> static bool decode(const guint8* data, gsize size, const Sink& sink)
+    {
+        if (size < 14 || data[0] != 0x20 || data[1] != 0x00)
+            return false;
+
+        const guint16 battery = uint16_be(data + 2);
+        if (battery != 0)
+            sink("BV", static_cast<int>(battery));
+
+        const gint16 temperature = int16_be(data + 4);
+        if (temperature != G_MININT16)
+            sink("T", temperature / 256.0);
+
+        sink("UP", static_cast<unsigned long>(uint32_be(data + 10) / 10));
+
+        return true;
+    }
+};
+
+/**
+ * ATC1441 and PVVX custom firmware formats, service data of UUID 0x181A.
+ * The two are told apart by payload length.
+ */
+struct Atc
+{
+    template <typename Sink> static bool decode(const guint8* data, gsize size, const Sink& sink)
+    {
+        if (size == 13)
+        {
+            sink("T", int16_be(data + 6) / 10.0);
+            sink("H", static_cast<int>(data[8]));
+            sink("B", static_cast<int>(data[9]));
+            sink("BV", static_cast<int>(uint16_be(data + 10)));
+            return true;
+        }
+
+        if (size >= 15)
+        {
+            sink("T", int16_le(data + 6) / 100.0);
+            sink("H", uint16_le(data + 8) / 100.0);
+            sink("BV", static_cast<int>(uint16_le(data + 10)));
+            sink("B", static_cast<int>(data[12]));
+            return true;
+        }
+
+        return false;
+    }
+};
+
+/**
+ * Battery Level carried as service data of the Battery Service, UUID 0x180F.
+ */
+struct BatteryLevel
+{
+    template <typename Sink> static bool decode(const guint8* data, gsize size, const Sink& sink)
+    {
+        if (size < 1 || data[0] > 100)
+            return false;
+
+        sink("B", static_cast<int>(data[0]));
+        return true;
+    }
+};
+
+}    // namespace decoders
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,311 @@
+#include "AdvertisementMonitor.h"
+#include "Scanner.h"
+#include "core/utilities/Logger.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+namespace
+{
+const char* const MONITOR_INTERFACE = "org.bluez.AdvertisementMonitor1";
+const char* const OBJECT_MANAGER_INTERFACE = "org.freedesktop.DBus.ObjectManager";
+const char* const ROOT_PREFIX = "/org/wolkabout/bluetooth/";
+
+const guint8 AD_TYPE_SERVICE_DATA = 0x16;
+const guint8 AD_TYPE_MANUFACTURER_DATA = 0xFF;
+
+const char* const INTROSPECTION = "<node>"
+                                  "  <interface name='org.freedesktop.DBus.ObjectManager'>"
+                                  "    <method name='GetManagedObjects'>"
+                                  "      <arg name='objects' type='a{oa{sa{sv}}}' direction='out'/>"
+                                  "    </method>"
+                                  "  </interface>"
+                                  "  <interface name='org.bluez.AdvertisementMonitor1'>"
+                                  "    <method name='Release'/>"
+                                  "    <method name='Activate'/>"
+                                  "    <method name='DeviceFound'>"
+                                  "      <arg name='device' type='o' direction='in'/>"
+                                  "    </method>"
+                                  "    <method name='DeviceLost'>"
+                                  "      <arg name='device' type='o' direction='in'/>"
+                                  "    </method>"
+                                  "    <property name='Type' type='s' access='read'/>"
+                                  "    <property name='RSSILowThreshold' type='n' access='read'/>"
+                                  "    <property name='RSSIHighThreshold' type='n' access='read'/>"
+                                  "    <property name='RSSILowTimeout' type='q' access='read'/>"
+                                  "    <property name='RSSIHighTimeout' type='q' access='read'/>"
+                                  "    <property name='Patterns' type='a(yyay)' access='read'/>"
+                                  "  </interface>"
+                                  "</node>";
+
+GDBusNodeInfo* introspection()
+{
+    static GDBusNodeInfo* info = g_dbus_node_info_new_for_xml(INTROSPECTION, NULL);
+    return info;
+}
+}    // namespace
+
+MonitorPattern beacon_pattern(const BeaconIdentity& identity)
+{
+    MonitorPattern pattern;
+    if (identity.type == BeaconIdentity::IBEACON)
+    {
+        // Apple company id, iBeacon type and length, then the identity
+        pattern.start = 0;
+        pattern.ad_type = AD_TYPE_MANUFACTURER_DATA;
+        pattern.content = {0x4C, 0x00, 0x02, 0x15};
+    }
+    else
+    {
+        // Eddystone UUID, UID frame and calibrated power precede the identity
+        pattern.start = 4;
+        pattern.ad_type = AD_TYPE_SERVICE_DATA;
+    }
+    pattern.content.insert(pattern.content.end(), identity.bytes, identity.bytes + identity.size);
+    return pattern;
+}
+
+AdvertisementMonitor::AdvertisementMonitor(const Adapter& monitored_adapter,
+                                           std::vector<MonitorPattern> monitor_patterns, void (*handler)(bool, void*),
+                                           void* user_data)
+: adapter(monitored_adapter)
+, patterns(std::move(monitor_patterns))
+, changed_handler(handler)
+, changed_data(user_data)
+, generation(0)
+, rssi_high(ADAPTER_RSSI_MIN)
+, rssi_low(ADAPTER_RSSI_MIN)
+, low_timeout(1)
+, root_registration(0)
+, monitor_registration(0)
+, is_registered(false)
+, is_active(false)
+{
+    const std::string& adapter_path = adapter.object_path();
+    root = ROOT_PREFIX + adapter_path.substr(adapter_path.rfind('/') + 1);
+}
+
+AdvertisementMonitor::~AdvertisementMonitor()
+{
+    if (monitor_registration != 0)
+        g_dbus_connection_unregister_object(Bus::connection(), monitor_registration);
+    if (root_registration != 0)
+        g_dbus_connection_unregister_object(Bus::connection(), root_registration);
+}
+
+void AdvertisementMonitor::set_rssi(int rssi, unsigned timeout)
+{
+    const gint16 high = static_cast<gint16>(std::max(std::min(rssi, ADAPTER_RSSI_MAX), ADAPTER_RSSI_MIN));
+    const gint16 low = static_cast<gint16>(std::max(high - RSSI_HYSTERESIS, ADAPTER_RSSI_MIN));
+    const guint16 lost = static_cast<guint16>(std::max(1u, std::min(timeout, static_cast<unsigned>(TIMEOUT_MAX))));
+    if (high == rssi_high && low == rssi_low && lost == low_timeout)
+        return;
+
+    rssi_high = high;
+    rssi_low = low;
+    low_timeout = lost;
+
+    // bluetoothd reads the thresholds once, so the monitor is replaced by one under a new path
+    if (monitor_registration != 0)
+    {
+        deactivate();
+        unexport_monitor();
+        ++generation;
+        export_monitor();
+    }
+}
+
+void AdvertisementMonitor::register_monitor()
+{
+    if (root_registration == 0)
+    {
+        GError* error = NULL;
+        static const GDBusInterfaceVTable vtable = {AdvertisementMonitor::method_call, NULL, NULL, {0}};
+        root_registration = g_dbus_connection_register_object(
+          Bus::connection(), root.c_str(), g_dbus_node_info_lookup_interface(introspection(), OBJECT_MANAGER_INTERFACE),
+          &vtable, this, NULL, &error);
+        if (error != NULL)
+        {
+            LOG(ERROR) << "Unable to export the advertisement monitor: " << error->message;
+            g_error_free(error);
+            return;
+        }
+    }
+    if (monitor_registration == 0)
+        export_monitor();
+
+    g_dbus_connection_call(Bus::connection(), "org.bluez", adapter.object_path().c_str(),
+                           "org.bluez.AdvertisementMonitorManager1", "RegisterMonitor",
+                           g_variant_new("(o)", root.c_str()), NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+                           AdvertisementMonitor::registered, this);
+}
+
+void AdvertisementMonitor::reset()
+{
+    is_registered = false;
+    deactivate();
+}
+
+void AdvertisementMonitor::export_monitor()
+{
+    path = root + "/monitor" + std::to_string(generation);
+
+    GError* error = NULL;
+    static const GDBusInterfaceVTable vtable = {AdvertisementMonitor::method_call, AdvertisementMonitor::get_property,
+                                                NULL, {0}};
+    monitor_registration = g_dbus_connection_register_object(
+      Bus::connection(), path.c_str(), g_dbus_node_info_lookup_interface(introspection(), MONITOR_INTERFACE), &vtable,
+      this, NULL, &error);
+    if (error != NULL)
+    {
+        LOG(ERROR) << "Unable to export the advertisement monitor: " << error->message;
+        g_error_free(error);
+        monitor_registration = 0;
+        return;
+    }
+
+    if (is_registered)
+    {
+        GVariantBuilder interfaces;
+        g_variant_builder_init(&interfaces, G_VARIANT_TYPE("a{sa{sv}}"));
+        g_variant_builder_add(&interfaces, "{s@a{sv}}", MONITOR_INTERFACE, properties());
+        g_dbus_connection_emit_signal(Bus::connection(), NULL, root.c_str(), OBJECT_MANAGER_INTERFACE,
+                                      "InterfacesAdded", g_variant_new("(oa{sa{sv}})", path.c_str(), &interfaces),
+                                      NULL);
+    }
+}
+
+void AdvertisementMonitor::unexport_monitor()
+{
+    g_dbus_connection_unregister_object(Bus::connection(), monitor_registration);
+    monitor_registration = 0;
+
+    if (is_registered)
+    {
+        const gchar* interfaces[] = {MONITOR_INTERFACE, NULL};
+        g_dbus_connection_emit_signal(Bus::connection(), NULL, root.c_str(), OBJECT_MANAGER_INTERFACE,
+                                      "InterfacesRemoved", g_variant_new("(o^as)", path.c_str(), interfaces), NULL);
+    }
+}
+
+void AdvertisementMonitor::deactivate()
+{
+    if (!is_active)
+        return;
+
+    is_active = false;
+    Scanner::monitor_released(adapter.object_path());
+    changed_handler(false, changed_data);
+}
+
+GVariant* AdvertisementMonitor::properties() const
+{
+    GVariantBuilder matches;
+    g_variant_builder_init(&matches, G_VARIANT_TYPE("a(yyay)"));
+    for (const auto& pattern : patterns)
+    {
+        g_variant_builder_add(&matches, "(yy@ay)", pattern.start, pattern.ad_type,
+                              g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, pattern.content.data(),
+                                                        pattern.content.size(), sizeof(guint8)));
+    }
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&builder, "{sv}", "Type", g_variant_new_string("or_patterns"));
+    g_variant_builder_add(&builder, "{sv}", "RSSIHighThreshold", g_variant_new_int16(rssi_high));
+    g_variant_builder_add(&builder, "{sv}", "RSSILowThreshold", g_variant_new_int16(rssi_low));
+    g_variant_builder_add(&builder, "{sv}", "RSSIHighTimeout", g_variant_new_uint16(1));
+    g_variant_builder_add(&builder, "{sv}", "RSSILowTimeout", g_variant_new_uint16(low_timeout));
+    g_variant_builder_add(&builder, "{sv}", "Patterns", g_variant_builder_end(&matches));
+    return g_variant_builder_end(&builder);
+}
+
+void AdvertisementMonitor::registered(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    AdvertisementMonitor* monitor = static_cast<AdvertisementMonitor*>(user_data);
+
+    GError* error = NULL;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+    {
+        LOG(INFO) << "Advertisement monitors are not available on " << monitor->adapter.object_path() << ", "
+                  << error->message << ". Discovering instead";
+        g_error_free(error);
+        return;
+    }
+    g_variant_unref(reply);
+    monitor->is_registered = true;
+}
+
+void AdvertisementMonitor::method_call(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                                       const gchar* interface, const gchar* method, GVariant* parameters,
+                                       GDBusMethodInvocation* invocation, gpointer user_data)
+{
+    (void)connection;
+    (void)sender;
+    (void)object_path;
+    (void)interface;
+
+    AdvertisementMonitor* monitor = static_cast<AdvertisementMonitor*>(user_data);
+
+    if (!g_strcmp0(method, "GetManagedObjects"))
+    {
+        GVariantBuilder objects;
+        g_variant_builder_init(&objects, G_VARIANT_TYPE("a{oa{sa{sv}}}"));
+        if (monitor->monitor_registration != 0)
+        {
+            GVariantBuilder interfaces;
+            g_variant_builder_init(&interfaces, G_VARIANT_TYPE("a{sa{sv}}"));
+            g_variant_builder_add(&interfaces, "{s@a{sv}}", MONITOR_INTERFACE, monitor->properties());
+            g_variant_builder_add(&objects, "{oa{sa{sv}}}", monitor->path.c_str(), &interfaces);
+        }
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{oa{sa{sv}}})", &objects));
+        return;
+    }
+
+    if (!g_strcmp0(method, "Activate"))
+    {
+        LOG(INFO) << "Advertisement monitor active on " << monitor->adapter.object_path();
+        monitor->is_active = true;
+        monitor->changed_handler(true, monitor->changed_data);
+    }
+    else if (!g_strcmp0(method, "Release"))
+    {
+        LOG(WARN) << "Advertisement monitor released on " << monitor->adapter.object_path()
+                  << ", discovering instead";
+        monitor->deactivate();
+    }
+    else if (!g_strcmp0(method, "DeviceFound") && monitor->is_active)
+    {
+        const gchar* device;
+        g_variant_get(parameters, "(&o)", &device);
+        Scanner::monitor_found(device);
+    }
+    else if (!g_strcmp0(method, "DeviceLost") && monitor->is_active)
+    {
+        const gchar* device;
+        g_variant_get(parameters, "(&o)", &device);
+        Scanner::monitor_lost(device);
+    }
+    g_dbus_method_invocation_return_value(invocation, NULL);
+}
+
+GVariant* AdvertisementMonitor::get_property(GDBusConnection* connection, const gchar* sender,
+                                             const gchar* object_path, const gchar* interface, const gchar* property,
+                                             GError** error, gpointer user_data)
+{
+    (void)connection;
+    (void)sender;
+    (void)object_path;
+    (void)interface;
+
+    GVariant* properties = static_cast<AdvertisementMonitor*>(user_data)->properties();
+    GVariant* value = g_variant_lookup_value(properties, property, NULL);
+    g_variant_unref(g_variant_ref_sink(properties));
+    if (value == NULL)
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY, "Unknown property %s", property);
+    return value;
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,113 @@
+#ifndef ADVERTISEMENTMONITOR_H
+#define ADVERTISEMENTMONITOR_H
+
+#include "Adapter.h"
+#include "BeaconIdentity.h"
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Matches advertisements carrying `content` at offset `start` of the data of
+ * AD type `ad_type`.
+ */
+struct MonitorPattern
+{
+    guint8 start;
+    guint8 ad_type;
+    std::vector<guint8> content;
+};
+
+/**
+ * Pattern of the advertisements broadcasting a beacon identity. Eddystone
+ * patterns skip the calibrated power, which differs between beacons.
+ */
+MonitorPattern beacon_pattern(const BeaconIdentity& identity);
+
+/**
+ * Registers an or_patterns org.bluez.AdvertisementMonitor1 with the
+ * AdvertisementMonitorManager1 of one adapter. Matching and presence timeouts
+ * are then left to bluetoothd, or to the controller where it supports
+ * offloading, and only matched devices reach the module. Found devices are
+ * held as sightings until they are lost.
+ *
+ * `handler` is called on the main loop when the monitor is activated and
+ * when bluetoothd releases it. While it is not active discovery has to run
+ * instead, which is also the case when the adapter has no monitor manager.
+ */
+class AdvertisementMonitor
+{
+public:
+    AdvertisementMonitor(const Adapter& adapter, std::vector<MonitorPattern> patterns, void (*handler)(bool, void*),
+                         void* user_data);
+
+    ~AdvertisementMonitor();
+
+    AdvertisementMonitor(const AdvertisementMonitor&) = delete;
+    AdvertisementMonitor& operator=(const AdvertisementMonitor&) = delete;
+
+    /**
+     * Devices are found at or above `rssi` dBm and lost after `timeout`
+     * seconds below it or out of range. Replaces the monitor when it is
+     * already registered.
+     */
+    void set_rssi(int rssi, unsigned timeout);
+
+    /**
+     * Exports the monitor and registers it asynchronously, also after
+     * bluetoothd restarted.
+     */
+    void register_monitor();
+
+    /**
+     * Forgets the registration, after bluetoothd restarted.
+     */
+    void reset();
+
+    bool active() const { return is_active; }
+
+private:
+    static const gint16 RSSI_HYSTERESIS = 5;
+    static const guint16 TIMEOUT_MAX = 300;
+
+    void export_monitor();
+    void unexport_monitor();
+
+    void deactivate();
+
+    GVariant* properties() const;
+
+    static void registered(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    static void method_call(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                            const gchar* interface, const gchar* method, GVariant* parameters,
+                            GDBusMethodInvocation* invocation, gpointer user_data);
+
+    static GVariant* get_property(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                                  const gchar* interface, const gchar* property, GError** error, gpointer user_data);
+
+    const Adapter& adapter;
+    std::vector<MonitorPattern> patterns;
+    void (*changed_handler)(bool, void*);
+    void* changed_data;
+
+    std::string root;
+    std::string path;
+    unsigned generation;
+
+    gint16 rssi_high;
+    gint16 rssi_low;
+    guint16 low_timeout;
+
+    guint root_registration;
+    guint monitor_registration;
+    bool is_registered;
+    bool is_active;
+};
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,182 @@
+#include "Aes128.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define AES128_X86 1
+#include <wmmintrin.h>
+#endif
+
+namespace wolkabout
+{
+namespace
+{
+const guint8 sbox[256] = {
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76, 0xca, 0x82, 0xc9,
+  0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, 0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f,
+  0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15, 0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07,
+  0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75, 0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3,
+  0x29, 0xe3, 0x2f, 0x84, 0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58,
+  0xcf, 0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8, 0x51, 0xa3,
+  0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, 0xcd, 0x0c, 0x13, 0xec, 0x5f,
+  0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73, 0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+  0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb, 0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac,
+  0x62, 0x91, 0x95, 0xe4, 0x79, 0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a,
+  0xae, 0x08, 0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a, 0x70,
+  0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, 0xe1, 0xf8, 0x98, 0x11,
+  0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf, 0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42,
+  0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
+
+const guint8 rcon[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+
+inline guint8 xtime(guint8 x)
+{
+    return static_cast<guint8>((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+inline void add_round_key(guint8* state, const guint8* round_key)
+{
+    for (gsize i = 0; i < AES128_BLOCK_SIZE; ++i)
+        state[i] ^= round_key[i];
+}
+
+inline void sub_shift_rows(guint8* state)
+{
+    guint8 tmp[AES128_BLOCK_SIZE];
+    for (gsize column = 0; column < 4; ++column)
+    {
+        for (gsize row = 0; row < 4; ++row)
+            tmp[column * 4 + row] = sbox[state[((column + row) % 4) * 4 + row]];
+    }
+    std::memcpy(state, tmp, AES128_BLOCK_SIZE);
+}
+
+inline void mix_columns(guint8* state)
+{
+    for (gsize column = 0; column < 4; ++column)
+    {
+        guint8* c = state + column * 4;
+        const guint8 all = static_cast<guint8>(c[0] ^ c[1] ^ c[2] ^ c[3]);
+        const guint8 first = c[0];
+        c[0] = static_cast<guint8>(c[0] ^ all ^ xtime(static_cast<guint8>(c[0] ^ c[1])));
+        c[1] = static_cast<guint8>(c[1] ^ all ^ xtime(static_cast<guint8>(c[1] ^ c[2])));
+        c[2] = static_cast<guint8>(c[2] ^ all ^ xtime(static_cast<guint8>(c[2] ^ c[3])));
+        c[3] = static_cast<guint8>(c[3] ^ all ^ xtime(static_cast<guint8>(c[3] ^ first)));
+    }
+}
+
+#ifdef AES128_X86
+__attribute__((target("aes,sse2"))) void encrypt_batch_aesni(const guint8* round_keys, gsize count,
+                                                             const guint8* in, guint8* out)
+{
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    gsize n = 0;
+
+    for (; n + 4 <= count; n += 4)
+    {
+        const __m128i* k0 = reinterpret_cast<const __m128i*>(round_keys + (n + 0) * AES128_ROUND_KEYS_SIZE);
+        const __m128i* k1 = reinterpret_cast<const __m128i*>(round_keys + (n + 1) * AES128_ROUND_KEYS_SIZE);
+        const __m128i* k2 = reinterpret_cast<const __m128i*>(round_keys + (n + 2) * AES128_ROUND_KEYS_SIZE);
+        const __m128i* k3 = reinterpret_cast<const __m128i*>(round_keys + (n + 3) * AES128_ROUND_KEYS_SIZE);
+
+        __m128i s0 = _mm_xor_si128(block, _mm_loadu_si128(k0));
+        __m128i s1 = _mm_xor_si128(block, _mm_loadu_si128(k1));
+        __m128i s2 = _mm_xor_si128(block, _mm_loadu_si128(k2));
+        __m128i s3 = _mm_xor_si128(block, _mm_loadu_si128(k3));
+        for (int round = 1; round < 10; ++round)
+        {
+            s0 = _mm_aesenc_si128(s0, _mm_loadu_si128(k0 + round));
+            s1 = _mm_aesenc_si128(s1, _mm_loadu_si128(k1 + round));
+            s2 = _mm_aesenc_si128(s2, _mm_loadu_si128(k2 + round));
+            s3 = _mm_aesenc_si128(s3, _mm_loadu_si128(k3 + round));
+        }
+        s0 = _mm_aesenclast_si128(s0, _mm_loadu_si128(k0 + 10));
+        s1 = _mm_aesenclast_si128(s1, _mm_loadu_si128(k1 + 10));
+        s2 = _mm_aesenclast_si128(s2, _mm_loadu_si128(k2 + 10));
+        s3 = _mm_aesenclast_si128(s3, _mm_loadu_si128(k3 + 10));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (n + 0) * AES128_BLOCK_SIZE), s0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (n + 1) * AES128_BLOCK_SIZE), s1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (n + 2) * AES128_BLOCK_SIZE), s2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (n + 3) * AES128_BLOCK_SIZE), s3);
+    }
+
+    for (; n < count; ++n)
+    {
+        const __m128i* k = reinterpret_cast<const __m128i*>(round_keys + n * AES128_ROUND_KEYS_SIZE);
+        __m128i s = _mm_xor_si128(block, _mm_loadu_si128(k));
+        for (int round = 1; round < 10; ++round)
+            s = _mm_aesenc_si128(s, _mm_loadu_si128(k + round));
+        s = _mm_aesenclast_si128(s, _mm_loadu_si128(k + 10));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n * AES128_BLOCK_SIZE), s);
+    }
+}
+#endif
+}    // namespace
+
+void aes128_expand_key(const guint8* key, guint8* round_keys)
+{
+    std::memcpy(round_keys, key, AES128_BLOCK_SIZE);
+
+    for (gsize i = 4; i < 44; ++i)
+    {
+        guint8 word[4];
+        std::memcpy(word, round_keys + (i - 1) * 4, 4);
+
+        if (i % 4 == 0)
+        {
+            const guint8 first = word[0];
+            word[0] = static_cast<guint8>(sbox[word[1]] ^ rcon[i / 4 - 1]);
+            word[1] = sbox[word[2]];
+            word[2] = sbox[word[3]];
+            word[3] = sbox[first];
+        }
+
+        for (gsize j = 0; j < 4; ++j)
+            round_keys[i * 4 + j] = static_cast<guint8>(round_keys[(i - 4) * 4 + j] ^ word[j]);
+    }
+}
+
+void aes128_encrypt(const guint8* round_keys, const guint8* in, guint8* out)
+{
+    guint8 state[AES128_BLOCK_SIZE];
+    std::memcpy(state, in, AES128_BLOCK_SIZE);
+
+    add_round_key(state, round_keys);
+    for (gsize round = 1; round < 10; ++round)
+    {
+        sub_shift_rows(state);
+        mix_columns(state);
+        add_round_key(state, round_keys + round * AES128_BLOCK_SIZE);
+    }
+    sub_shift_rows(state);
+    add_round_key(state, round_keys + 10 * AES128_BLOCK_SIZE);
+
+    std::memcpy(out, state, AES128_BLOCK_SIZE);
+}
+
+bool aes128_hardware_supported()
+{
+#ifdef AES128_X86
+    static const bool supported = __builtin_cpu_supports("aes");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void aes128_encrypt_batch(const guint8* round_keys, gsize count, const guint8* in, guint8* out)
+{
+#ifdef AES128_X86
+    if (aes128_hardware_supported())
+    {
+        encrypt_batch_aesni(round_keys, count, in, out);
+        return;
+    }
+#endif
+
+    for (gsize n = 0; n < count; ++n)
+        aes128_encrypt(round_keys + n * AES128_ROUND_KEYS_SIZE, in, out + n * AES128_BLOCK_SIZE);
+}
+
+}    // namespace wolkabout
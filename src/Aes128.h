@@ -0,0 +1,25 @@
+#ifndef AES128_H
+#define AES128_H
+
+#include <glib.h>
+
+namespace wolkabout
+{
+const gsize AES128_BLOCK_SIZE = 16;
+const gsize AES128_ROUND_KEYS_SIZE = 176;
+
+void aes128_expand_key(const guint8* key, guint8* round_keys);
+
+void aes128_encrypt(const guint8* round_keys, const guint8* in, guint8* out);
+
+/**
+ * Encrypts one block under `count` expanded keys stored back to back in
+ * `round_keys`, writing `count` blocks to `out`. Uses AES-NI when the CPU
+ * supports it, interleaving several keys to hide instruction latency.
+ */
+void aes128_encrypt_batch(const guint8* round_keys, gsize count, const guint8* in, guint8* out);
+
+bool aes128_hardware_supported();
+
+}    // namespace wolkabout
+#endif
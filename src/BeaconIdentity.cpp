@@ -0,0 +1,167 @@
+#include "BeaconIdentity.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace wolkabout
+{
+namespace
+{
+const guint16 APPLE_COMPANY_ID = 0x004C;
+const char* const EDDYSTONE_UUID = "0000feaa-0000-1000-8000-00805f9b34fb";
+
+bool parse_hex(const std::string& hex, guint8* out, gsize size)
+{
+    std::string digits;
+    for (char c : hex)
+    {
+        if (c != '-')
+            digits.push_back(c);
+    }
+
+    if (digits.size() != size * 2)
+        return false;
+
+    for (gsize i = 0; i < size; ++i)
+    {
+        const int high = g_ascii_xdigit_value(digits[2 * i]);
+        const int low = g_ascii_xdigit_value(digits[2 * i + 1]);
+        if (high < 0 || low < 0)
+            return false;
+        out[i] = static_cast<guint8>((high << 4) | low);
+    }
+    return true;
+}
+
+bool parse_uint16(const std::string& value, guint8* out)
+{
+    char* end = nullptr;
+    const unsigned long number = std::strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || number > G_MAXUINT16)
+        return false;
+
+    out[0] = static_cast<guint8>(number >> 8);
+    out[1] = static_cast<guint8>(number & 0xFF);
+    return true;
+}
+
+const guint8* payload_bytes(GVariant* payload, gsize& size)
+{
+    return static_cast<const guint8*>(g_variant_get_fixed_array(payload, &size, 1));
+}
+}    // namespace
+
+bool BeaconIdentity::operator==(const BeaconIdentity& other) const
+{
+    return type == other.type && size == other.size && std::memcmp(bytes, other.bytes, size) == 0;
+}
+
+std::size_t BeaconIdentityHash::operator()(const BeaconIdentity& identity) const
+{
+    std::size_t hash = 2166136261u ^ identity.type;
+    for (gsize i = 0; i < identity.size; ++i)
+    {
+        hash = (hash ^ identity.bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool parse_beacon_key(const std::string& key, BeaconIdentity& identity)
+{
+    std::vector<std::string> parts;
+    std::string::size_type start = 0, end;
+    while ((end = key.find(':', start)) != std::string::npos)
+    {
+        parts.push_back(key.substr(start, end - start));
+        start = end + 1;
+    }
+    parts.push_back(key.substr(start));
+
+    if (parts.size() == 4 && !g_ascii_strcasecmp(parts[0].c_str(), "ibeacon"))
+    {
+        identity.type = BeaconIdentity::IBEACON;
+        identity.size = 20;
+        return parse_hex(parts[1], identity.bytes, 16) && parse_uint16(parts[2], identity.bytes + 16) &&
+               parse_uint16(parts[3], identity.bytes + 18);
+    }
+
+    if (parts.size() == 3 && !g_ascii_strcasecmp(parts[0].c_str(), "eddystone"))
+    {
+        identity.type = BeaconIdentity::EDDYSTONE_UID;
+        identity.size = 16;
+        return parse_hex(parts[1], identity.bytes, 10) && parse_hex(parts[2], identity.bytes + 10, 6);
+    }
+
+    return false;
+}
+
+void BeaconIndex::add(const BeaconIdentity& identity, const std::string& key)
+{
+    identities[identity] = key;
+}
+
+bool BeaconIndex::empty() const
+{
+    return identities.empty();
+}
+
+const std::string* BeaconIndex::resolve(GVariant* manufacturer_data, GVariant* service_data) const
+{
+    GVariantIter i;
+    GVariant* payload;
+    BeaconIdentity identity;
+    const std::string* key = nullptr;
+
+    if (manufacturer_data != NULL)
+    {
+        guint16 company_id;
+        g_variant_iter_init(&i, manufacturer_data);
+        while (key == nullptr && g_variant_iter_next(&i, "{qv}", &company_id, &payload))
+        {
+            gsize size;
+            const guint8* data = payload_bytes(payload, size);
+
+            // iBeacon: type 0x02, length 0x15, UUID, major, minor, measured power
+            if (company_id == APPLE_COMPANY_ID && size >= 23 && data[0] == 0x02 && data[1] == 0x15)
+            {
+                identity.type = BeaconIdentity::IBEACON;
+                identity.size = 20;
+                std::memcpy(identity.bytes, data + 2, 20);
+
+                auto it = identities.find(identity);
+                if (it != identities.end())
+                    key = &it->second;
+            }
+            g_variant_unref(payload);
+        }
+    }
+
+    if (service_data != NULL)
+    {
+        const gchar* uuid;
+        g_variant_iter_init(&i, service_data);
+        while (key == nullptr && g_variant_iter_next(&i, "{&sv}", &uuid, &payload))
+        {
+            gsize size;
+            const guint8* data = payload_bytes(payload, size);
+
+            // Eddystone-UID: frame type 0x00, TX power, namespace, instance
+            if (size >= 18 && data[0] == 0x00 && !g_ascii_strcasecmp(uuid, EDDYSTONE_UUID))
+            {
+                identity.type = BeaconIdentity::EDDYSTONE_UID;
+                identity.size = 16;
+                std::memcpy(identity.bytes, data + 2, 16);
+
+                auto it = identities.find(identity);
+                if (it != identities.end())
+                    key = &it->second;
+            }
+            g_variant_unref(payload);
+        }
+    }
+
+    return key;
+}
+
+}    // namespace wolkabout
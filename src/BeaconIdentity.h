@@ -0,0 +1,63 @@
+#ifndef BEACONIDENTITY_H
+#define BEACONIDENTITY_H
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <string>
+#include <unordered_map>
+
+namespace wolkabout
+{
+/**
+ * Identity broadcast by a beacon, independent of the address it advertises from.
+ * iBeacon identities are UUID, major and minor (20 bytes), Eddystone-UID
+ * identities are namespace and instance (16 bytes).
+ */
+struct BeaconIdentity
+{
+    enum Type : guint8
+    {
+        NONE = 0,
+        IBEACON,
+        EDDYSTONE_UID
+    };
+
+    static const gsize MAX_SIZE = 20;
+
+    guint8 type = NONE;
+    guint8 size = 0;
+    guint8 bytes[MAX_SIZE] = {};
+
+    bool operator==(const BeaconIdentity& other) const;
+};
+
+struct BeaconIdentityHash
+{
+    std::size_t operator()(const BeaconIdentity& identity) const;
+};
+
+/**
+ * Parses configuration keys in "IBEACON:<uuid>:<major>:<minor>" or
+ * "EDDYSTONE:<namespace>:<instance>" form. Returns false for any other key.
+ */
+bool parse_beacon_key(const std::string& key, BeaconIdentity& identity);
+
+class BeaconIndex
+{
+public:
+    void add(const BeaconIdentity& identity, const std::string& key);
+
+    bool empty() const;
+
+    /**
+     * Looks up the identities carried in the ManufacturerData (a{qv}) and
+     * ServiceData (a{sv}) properties of a device. Either may be NULL.
+     */
+    const std::string* resolve(GVariant* manufacturer_data, GVariant* service_data) const;
+
+private:
+    std::unordered_map<BeaconIdentity, std::string, BeaconIdentityHash> identities;
+};
+
+}    // namespace wolkabout
+#endif
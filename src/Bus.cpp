@@ -0,0 +1,85 @@
+#include "Bus.h"
+#include "core/utilities/Logger.h"
+
+namespace wolkabout
+{
+GDBusConnection* Bus::s_connection = nullptr;
+GMainLoop* Bus::s_loop = nullptr;
+void (*Bus::s_restarted)(void*) = nullptr;
+void* Bus::s_restarted_data = nullptr;
+
+GDBusConnection* Bus::connection()
+{
+    if (s_connection == nullptr)
+    {
+        GError* error = NULL;
+        s_connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+        if (error != NULL)
+        {
+            LOG(ERROR) << "Unable to connect to the system bus: " << error->message;
+            g_error_free(error);
+        }
+    }
+    return s_connection;
+}
+
+void Bus::set_connection(GDBusConnection* connection)
+{
+    if (s_connection != nullptr)
+        g_object_unref(s_connection);
+    s_connection = connection != nullptr ? G_DBUS_CONNECTION(g_object_ref(connection)) : nullptr;
+}
+
+GMainLoop* Bus::loop()
+{
+    if (s_loop == nullptr)
+        s_loop = g_main_loop_new(NULL, FALSE);
+    return s_loop;
+}
+
+void Bus::run()
+{
+    g_main_loop_run(loop());
+}
+
+void Bus::watch_bluez(void (*f)(void*), void* user_data)
+{
+    const bool subscribed = s_restarted != nullptr;
+    s_restarted = f;
+    s_restarted_data = user_data;
+
+    if (!subscribed)
+    {
+        g_dbus_connection_signal_subscribe(connection(), "org.freedesktop.DBus", "org.freedesktop.DBus",
+                                           "NameOwnerChanged", "/org/freedesktop/DBus", "org.bluez",
+                                           G_DBUS_SIGNAL_FLAGS_NONE, Bus::name_owner_changed, NULL, NULL);
+    }
+}
+
+void Bus::name_owner_changed(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                             const gchar* interface, const gchar* signal, GVariant* parameters, gpointer user_data)
+{
+    (void)connection;
+    (void)sender;
+    (void)path;
+    (void)interface;
+    (void)signal;
+    (void)user_data;
+
+    const gchar* name;
+    const gchar* old_owner;
+    const gchar* new_owner;
+    g_variant_get(parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+
+    if (*new_owner == '\0')
+    {
+        LOG(WARN) << "bluetoothd stopped";
+        return;
+    }
+
+    LOG(INFO) << "bluetoothd started as " << new_owner;
+    if (s_restarted != nullptr)
+        s_restarted(s_restarted_data);
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,49 @@
+#ifndef BUS_H
+#define BUS_H
+
+#include <gio/gio.h>
+#include <glib.h>
+
+namespace wolkabout
+{
+/**
+ * The system bus connection and main loop shared by all components. Both are
+ * created on first use and live until the process exits.
+ */
+class Bus
+{
+public:
+    static GDBusConnection* connection();
+
+    /**
+     * Uses `connection` instead of the system bus, for tests against a
+     * private bus. Must be called before anything uses the connection.
+     */
+    static void set_connection(GDBusConnection* connection);
+
+    static GMainLoop* loop();
+
+    static void run();
+
+    /**
+     * Calls `f` on the main loop whenever org.bluez gets a new owner, which
+     * happens when bluetoothd is restarted. Everything bluetoothd knew is lost
+     * by then: adapters are unpowered, discovery is stopped and devices,
+     * connections and notifications are gone.
+     */
+    static void watch_bluez(void (*f)(void*), void* user_data);
+
+private:
+    static void name_owner_changed(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                   const gchar* interface, const gchar* signal, GVariant* parameters,
+                                   gpointer user_data);
+
+    static GDBusConnection* s_connection;
+    static GMainLoop* s_loop;
+
+    static void (*s_restarted)(void*);
+    static void* s_restarted_data;
+};
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,208 @@
+#include "CborProtocol.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <glib.h>
+
+namespace wolkabout
+{
+namespace
+{
+const std::string PROTOCOL_NAME = "CBOR_PROTOCOL";
+const std::string SENSOR_READING_TOPIC_ROOT = "d2p/sensor_reading/d/";
+
+enum CborMajor : guint8
+{
+    CBOR_UNSIGNED = 0,
+    CBOR_NEGATIVE = 1,
+    CBOR_TEXT = 3,
+    CBOR_ARRAY = 4
+};
+
+const char CBOR_FALSE = '\xf4';
+const char CBOR_TRUE = '\xf5';
+const char CBOR_DOUBLE = '\xfb';
+
+void write_head(std::string& out, guint8 major, guint64 value)
+{
+    const char type = static_cast<char>(major << 5);
+    if (value < 24)
+    {
+        out.push_back(static_cast<char>(type | static_cast<char>(value)));
+        return;
+    }
+
+    int bytes;
+    if (value <= G_MAXUINT8)
+    {
+        out.push_back(static_cast<char>(type | 24));
+        bytes = 1;
+    }
+    else if (value <= G_MAXUINT16)
+    {
+        out.push_back(static_cast<char>(type | 25));
+        bytes = 2;
+    }
+    else if (value <= G_MAXUINT32)
+    {
+        out.push_back(static_cast<char>(type | 26));
+        bytes = 4;
+    }
+    else
+    {
+        out.push_back(static_cast<char>(type | 27));
+        bytes = 8;
+    }
+
+    for (int i = bytes - 1; i >= 0; --i)
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+void write_text(std::string& out, const std::string& text)
+{
+    write_head(out, CBOR_TEXT, text.size());
+    out.append(text);
+}
+
+bool skip_digits(const char*& p)
+{
+    const char* start = p;
+    while (g_ascii_isdigit(*p))
+        ++p;
+    return p != start;
+}
+
+// Decimal numbers as JSON writes them, so values such as "0x1A", "007", " 5" or "nan" stay text
+bool is_decimal(const std::string& value, bool& integral)
+{
+    const char* p = value.c_str();
+    if (*p == '-')
+        ++p;
+
+    if (*p == '0')
+        ++p;
+    else if (!skip_digits(p))
+        return false;
+
+    integral = true;
+    if (*p == '.')
+    {
+        ++p;
+        if (!skip_digits(p))
+            return false;
+        integral = false;
+    }
+
+    if (*p == 'e' || *p == 'E')
+    {
+        ++p;
+        if (*p == '+' || *p == '-')
+            ++p;
+        if (!skip_digits(p))
+            return false;
+        integral = false;
+    }
+
+    return p == value.c_str() + value.size();
+}
+
+void write_value(std::string& out, const std::string& value)
+{
+    bool integral;
+    if (!is_decimal(value, integral))
+    {
+        if (value == "true" || value == "false")
+            out.push_back(value == "true" ? CBOR_TRUE : CBOR_FALSE);
+        else
+            write_text(out, value);
+        return;
+    }
+
+    if (integral)
+    {
+        errno = 0;
+        const long long integer = strtoll(value.c_str(), NULL, 10);
+        if (errno == 0)
+        {
+            if (integer >= 0)
+                write_head(out, CBOR_UNSIGNED, static_cast<guint64>(integer));
+            else
+                write_head(out, CBOR_NEGATIVE, static_cast<guint64>(-(integer + 1)));
+            return;
+        }
+    }
+
+    // Integers out of range are sent as doubles, numbers beyond the range of doubles as text
+    errno = 0;
+    const double real = strtod(value.c_str(), NULL);
+    if (errno == 0)
+    {
+        guint64 bits;
+        memcpy(&bits, &real, sizeof(bits));
+        out.push_back(CBOR_DOUBLE);
+        for (int i = 7; i >= 0; --i)
+            out.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+        return;
+    }
+
+    write_text(out, value);
+}
+
+void write_reading(std::string& out, const SensorReading& reading, const std::string& delimiter)
+{
+    const bool has_rtc = reading.getRtc() != 0;
+    write_head(out, CBOR_ARRAY, has_rtc ? 3 : 2);
+    write_text(out, reading.getReference());
+
+    const std::string& value = reading.getValue();
+    if (delimiter.empty() || value.find(delimiter) == std::string::npos)
+    {
+        write_value(out, value);
+    }
+    else
+    {
+        std::vector<std::string> parts;
+        std::string::size_type start = 0;
+        for (;;)
+        {
+            const auto next = value.find(delimiter, start);
+            parts.push_back(value.substr(start, next - start));
+            if (next == std::string::npos)
+                break;
+            start = next + delimiter.size();
+        }
+
+        write_head(out, CBOR_ARRAY, parts.size());
+        for (const auto& part : parts)
+            write_value(out, part);
+    }
+
+    if (has_rtc)
+        write_head(out, CBOR_UNSIGNED, reading.getRtc());
+}
+}    // namespace
+
+const std::string& CborProtocol::getName() const
+{
+    return PROTOCOL_NAME;
+}
+
+std::unique_ptr<Message> CborProtocol::makeMessage(const std::string& deviceKey,
+                                                   const std::vector<std::shared_ptr<SensorReading>>& sensorReadings,
+                                                   const std::string& delimiter) const
+{
+    if (sensorReadings.empty())
+        return nullptr;
+
+    std::string payload;
+    payload.reserve(sensorReadings.size() * 16);
+
+    write_head(payload, CBOR_ARRAY, sensorReadings.size());
+    for (const auto& reading : sensorReadings)
+        write_reading(payload, *reading, delimiter);
+
+    return std::unique_ptr<Message>(new Message(payload, SENSOR_READING_TOPIC_ROOT + deviceKey));
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,33 @@
+#ifndef CBORPROTOCOL_H
+#define CBORPROTOCOL_H
+
+#include "core/protocol/json/JsonProtocol.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Sends sensor readings as CBOR instead of JSON, everything else is exchanged
+ * as with the JSON protocol. All readings of a device are one message on
+ * "d2p/sensor_reading/d/<device key>" whose payload is an array with one
+ * [reference, value] or [reference, value, rtc] array per reading. Numeric and
+ * boolean values are encoded as such, multi-value readings as arrays of values.
+ * Only values written as JSON numbers are numeric, anything else is text.
+ */
+class CborProtocol : public JsonProtocol
+{
+public:
+    using JsonProtocol::makeMessage;
+
+    const std::string& getName() const override;
+
+    std::unique_ptr<Message> makeMessage(const std::string& deviceKey,
+                                         const std::vector<std::shared_ptr<SensorReading>>& sensorReadings,
+                                         const std::string& delimiter) const override;
+};
+
+}    // namespace wolkabout
+#endif
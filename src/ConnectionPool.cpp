@@ -0,0 +1,27 @@
+#include "ConnectionPool.h"
+
+namespace wolkabout
+{
+ConnectionPool::ConnectionPool(unsigned max_connections) : capacity(max_connections), in_use(0) {}
+
+bool ConnectionPool::try_acquire()
+{
+    if (in_use >= capacity)
+        return false;
+
+    ++in_use;
+    return true;
+}
+
+void ConnectionPool::release()
+{
+    if (in_use > 0)
+        --in_use;
+}
+
+unsigned ConnectionPool::available() const
+{
+    return capacity - in_use;
+}
+
+}    // namespace wolkabout
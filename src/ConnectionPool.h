@@ -0,0 +1,27 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+namespace wolkabout
+{
+/**
+ * Bounds the number of simultaneous LE connections opened on one adapter so
+ * the controller's connection limit is never exceeded.
+ */
+class ConnectionPool
+{
+public:
+    explicit ConnectionPool(unsigned capacity);
+
+    bool try_acquire();
+
+    void release();
+
+    unsigned available() const;
+
+private:
+    unsigned capacity;
+    unsigned in_use;
+};
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,172 @@
+#include "DeviceRegistry.h"
+
+#include <cmath>
+
+namespace wolkabout
+{
+bool parse_signal_sensor(const std::string& name, SignalSensor& sensor)
+{
+    static const struct
+    {
+        const char* name;
+        SignalSensor sensor;
+    } sensors[] = {{"rssi", SIGNAL_RSSI},
+                   {"txPower", SIGNAL_TX_POWER},
+                   {"distance", SIGNAL_DISTANCE},
+                   {"sightings", SIGNAL_SIGHTINGS},
+                   {"zone", SIGNAL_ZONE}};
+
+    for (const auto& entry : sensors)
+    {
+        if (name == entry.name)
+        {
+            sensor = entry.sensor;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DeviceRegistry::set_zones(const std::vector<AdapterZone>& adapter_zones)
+{
+    zones = adapter_zones;
+}
+
+void DeviceRegistry::add(const std::string& key, const SignalTemplate& signal)
+{
+    if (signal.sensors == 0 || index.find(key) != index.end())
+        return;
+
+    index[key] = slots.size();
+    slots.push_back(Slot{key, signal, 0, false, 0, false});
+    zone_sum.resize(slots.size() * zones.size(), 0);
+    zone_count.resize(slots.size() * zones.size(), 0);
+    filter.add_slot(static_cast<float>(signal.process_noise), static_cast<float>(signal.measurement_noise),
+                    static_cast<float>(signal.gain), static_cast<float>(signal.measured_power),
+                    static_cast<float>(signal.path_loss_exponent));
+}
+
+bool DeviceRegistry::empty() const
+{
+    return slots.empty();
+}
+
+gsize DeviceRegistry::find(const std::string& key) const
+{
+    const auto it = index.find(key);
+    return it == index.end() ? NO_SLOT : it->second;
+}
+
+void DeviceRegistry::record(gsize slot, gsize adapter, const gint16* rssi, const gint16* tx_power)
+{
+    Slot& s = slots[slot];
+    ++s.sightings;
+
+    if (rssi != NULL && (s.signal.sensors & (SIGNAL_RSSI | SIGNAL_DISTANCE)))
+        filter.add(slot, *rssi);
+
+    if (rssi != NULL && (s.signal.sensors & SIGNAL_ZONE) && adapter < zones.size())
+    {
+        zone_sum[slot * zones.size() + adapter] += *rssi;
+        ++zone_count[slot * zones.size() + adapter];
+
+        // Only devices heard in the interval get their zone recomputed
+        if (!s.zone_changed)
+        {
+            s.zone_changed = true;
+            changed_zones.push_back(slot);
+        }
+    }
+
+    if (tx_power != NULL && (s.signal.sensors & SIGNAL_TX_POWER))
+    {
+        s.tx_power = *tx_power;
+        s.has_tx_power = true;
+    }
+}
+
+void DeviceRegistry::publish(ReadingOutlet& outlet)
+{
+    filter.update();
+
+    for (gsize i = 0; i < slots.size(); ++i)
+    {
+        Slot& slot = slots[i];
+        const unsigned sensors = slot.signal.sensors;
+        if (sensors & SIGNAL_SIGHTINGS)
+            outlet.add(slot.key, "S", slot.sightings);
+
+        // Devices not heard in the interval have nothing but their sighting count to report
+        if (slot.sightings == 0)
+            continue;
+
+        if (filter.updated(i))
+        {
+            if (sensors & SIGNAL_RSSI)
+                outlet.add(slot.key, "RSSI", static_cast<double>(filter.rssi(i)));
+            if (sensors & SIGNAL_DISTANCE)
+                outlet.add(slot.key, "D", static_cast<double>(filter.distance(i)));
+        }
+
+        if ((sensors & SIGNAL_TX_POWER) && slot.has_tx_power)
+            outlet.add(slot.key, "TX", static_cast<int>(slot.tx_power));
+
+        slot.sightings = 0;
+        slot.has_tx_power = false;
+    }
+
+    for (gsize slot : changed_zones)
+        publish_zone(outlet, slot);
+    changed_zones.clear();
+}
+
+void DeviceRegistry::publish_zone(ReadingOutlet& outlet, gsize slot)
+{
+    Slot& s = slots[slot];
+    gint32* sums = &zone_sum[slot * zones.size()];
+    guint32* counts = &zone_count[slot * zones.size()];
+
+    gsize strongest = zones.size();
+    double strongest_rssi = 0;
+    double weight_sum = 0;
+    double x = 0;
+    double y = 0;
+
+    for (gsize i = 0; i < zones.size(); ++i)
+    {
+        if (counts[i] == 0)
+            continue;
+
+        const double rssi = static_cast<double>(sums[i]) / counts[i];
+        if (strongest == zones.size() || rssi > strongest_rssi)
+        {
+            strongest = i;
+            strongest_rssi = rssi;
+        }
+
+        // Weigh positions by received power in milliwatts
+        if (zones[i].positioned)
+        {
+            const double weight = std::pow(10.0, rssi / 10);
+            weight_sum += weight;
+            x += weight * zones[i].x;
+            y += weight * zones[i].y;
+        }
+
+        sums[i] = 0;
+        counts[i] = 0;
+    }
+
+    s.zone_changed = false;
+    if (strongest == zones.size())
+        return;
+
+    outlet.add(s.key, "Z", zones[strongest].zone);
+    if (weight_sum > 0)
+    {
+        outlet.add(s.key, "ZX", x / weight_sum);
+        outlet.add(s.key, "ZY", y / weight_sum);
+    }
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,114 @@
+#ifndef DEVICEREGISTRY_H
+#define DEVICEREGISTRY_H
+
+#include "ReadingOutlet.h"
+#include "RssiFilter.h"
+
+#include <glib.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Signal quality sensors a device template can enable on top of presence.
+ */
+enum SignalSensor : unsigned
+{
+    SIGNAL_RSSI = 1 << 0,
+    SIGNAL_TX_POWER = 1 << 1,
+    SIGNAL_DISTANCE = 1 << 2,
+    SIGNAL_SIGHTINGS = 1 << 3,
+    SIGNAL_ZONE = 1 << 4
+};
+
+/**
+ * Zone covered by an adapter. Devices are placed in the zone of the adapter
+ * that hears them strongest; when adapters have positions, a signal weighted
+ * centroid of the positions is estimated as well.
+ */
+struct AdapterZone
+{
+    std::string adapter;
+    unsigned zone;
+    bool positioned;
+    double x;
+    double y;
+};
+
+/**
+ * `measured_power` is the RSSI at one metre used by the log-distance path
+ * loss model, together with `path_loss_exponent` (2 in free space). RSSI is
+ * filtered with a Kalman filter when `gain` is zero, otherwise smoothed
+ * exponentially with `gain` as the weight of new samples.
+ */
+struct SignalTemplate
+{
+    unsigned sensors;
+    double measured_power;
+    double path_loss_exponent;
+    double process_noise;
+    double measurement_noise;
+    double gain;
+};
+
+bool parse_signal_sensor(const std::string& name, SignalSensor& sensor);
+
+/**
+ * Per-interval signal statistics of the devices whose template enables any
+ * signal sensor. Devices are assigned a slot when added, sightings only touch
+ * the accumulators of their slot, and `publish` filters the RSSI of all slots
+ * in one batch before handing the enabled sensors of sighted devices to Wolk.
+ * Sighting counts are handed for every device, zero when it was not heard.
+ */
+class DeviceRegistry
+{
+public:
+    static const gsize NO_SLOT = static_cast<gsize>(-1);
+
+    /**
+     * One zone per adapter, in adapter order. Must be set before devices are
+     * added.
+     */
+    void set_zones(const std::vector<AdapterZone>& adapter_zones);
+
+    void add(const std::string& key, const SignalTemplate& signal);
+
+    bool empty() const;
+
+    gsize find(const std::string& key) const;
+
+    /**
+     * `rssi` and `tx_power` may be NULL when the sighting did not carry them.
+     */
+    void record(gsize slot, gsize adapter, const gint16* rssi, const gint16* tx_power);
+
+    void publish(ReadingOutlet& outlet);
+
+private:
+    struct Slot
+    {
+        std::string key;
+        SignalTemplate signal;
+        guint32 sightings;
+        bool has_tx_power;
+        gint16 tx_power;
+        bool zone_changed;
+    };
+
+    void publish_zone(ReadingOutlet& outlet, gsize slot);
+
+    std::vector<Slot> slots;
+    RssiFilter filter;
+
+    // Per slot and adapter RSSI sums of the interval, slot major
+    std::vector<AdapterZone> zones;
+    std::vector<gint32> zone_sum;
+    std::vector<guint32> zone_count;
+    std::vector<gsize> changed_zones;
+    std::unordered_map<std::string, gsize> index;
+};
+
+}    // namespace wolkabout
+#endif
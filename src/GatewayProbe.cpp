@@ -0,0 +1,98 @@
+#include "GatewayProbe.h"
+#include "core/utilities/Logger.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+namespace
+{
+const guint16 DEFAULT_MQTT_PORT = 1883;
+const guint PROBE_TIMEOUT = 2;
+}    // namespace
+
+GatewayProbe::GatewayProbe(std::string broker_uri, void (*on_change)(bool, void*), void* user_data)
+: uri(std::move(broker_uri))
+, handler(on_change)
+, handler_data(user_data)
+, client(g_socket_client_new())
+, cancellable(g_cancellable_new())
+, timer(0)
+, probing(false)
+, is_reachable(true)
+, started(0)
+, reached(0)
+{
+    g_socket_client_set_timeout(client, PROBE_TIMEOUT);
+}
+
+GatewayProbe::~GatewayProbe()
+{
+    if (timer != 0)
+        g_source_remove(timer);
+
+    // A pending probe still holds the cancellable and must not call back into this object
+    g_cancellable_cancel(cancellable);
+    g_object_unref(cancellable);
+    g_object_unref(client);
+}
+
+void GatewayProbe::start(unsigned interval)
+{
+    if (timer != 0)
+        g_source_remove(timer);
+
+    timer = g_timeout_add_seconds(interval, probe, this);
+    probe(this);
+}
+
+gboolean GatewayProbe::probe(gpointer user_data)
+{
+    GatewayProbe* self = static_cast<GatewayProbe*>(user_data);
+    if (!self->probing)
+    {
+        self->probing = true;
+        self->started = g_get_monotonic_time();
+        g_socket_client_connect_to_uri_async(self->client, self->uri.c_str(), DEFAULT_MQTT_PORT, self->cancellable,
+                                             connected, self);
+    }
+    return TRUE;
+}
+
+void GatewayProbe::connected(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    GError* error = NULL;
+    GSocketConnection* connection = g_socket_client_connect_to_uri_finish(G_SOCKET_CLIENT(source), result, &error);
+
+    if (error != NULL && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        g_error_free(error);
+        return;
+    }
+
+    GatewayProbe* self = static_cast<GatewayProbe*>(user_data);
+    self->probing = false;
+
+    const bool reachable = connection != NULL;
+    if (connection != NULL)
+    {
+        self->reached = self->started;
+        g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+        g_object_unref(connection);
+    }
+    if (error != NULL)
+    {
+        LOG(DEBUG) << "Gateway probe failed: " << error->message;
+        g_error_free(error);
+    }
+
+    if (reachable != self->is_reachable)
+    {
+        self->is_reachable = reachable;
+        LOG(INFO) << "Gateway " << (reachable ? "reachable" : "unreachable");
+        if (self->handler != nullptr)
+            self->handler(reachable, self->handler_data);
+    }
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,55 @@
+#ifndef GATEWAYPROBE_H
+#define GATEWAYPROBE_H
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * Periodically opens a TCP connection to the gateway's MQTT broker to tell
+ * whether readings published now would reach it. The handler is called on
+ * the main loop whenever reachability changes.
+ */
+class GatewayProbe
+{
+public:
+    GatewayProbe(std::string broker_uri, void (*on_change)(bool reachable, void* user_data), void* user_data);
+
+    ~GatewayProbe();
+
+    GatewayProbe(const GatewayProbe&) = delete;
+    GatewayProbe& operator=(const GatewayProbe&) = delete;
+
+    void start(unsigned interval);
+
+    bool reachable() const { return is_reachable; }
+
+    /**
+     * Monotonic time at which the last successful probe started, zero before
+     * the first one. Anything sent before it went out while the gateway was
+     * reachable.
+     */
+    gint64 last_reachable() const { return reached; }
+
+private:
+    static gboolean probe(gpointer user_data);
+
+    static void connected(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    std::string uri;
+    void (*handler)(bool, void*);
+    void* handler_data;
+
+    GSocketClient* client;
+    GCancellable* cancellable;
+    guint timer;
+    bool probing;
+    bool is_reachable;
+    gint64 started;
+    gint64 reached;
+};
+
+}    // namespace wolkabout
+#endif
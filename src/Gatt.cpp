@@ -0,0 +1,189 @@
+#include "Gatt.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+
+namespace wolkabout
+{
+bool parse_gatt_format(const std::string& name, GattFormat& format)
+{
+    static const struct
+    {
+        const char* name;
+        GattFormat format;
+    } formats[] = {{"uint8", GattFormat::UINT8},   {"int8", GattFormat::INT8},   {"uint16", GattFormat::UINT16},
+                   {"int16", GattFormat::INT16},   {"uint32", GattFormat::UINT32}, {"int32", GattFormat::INT32},
+                   {"float32", GattFormat::FLOAT32}};
+
+    for (const auto& entry : formats)
+    {
+        if (name == entry.name)
+        {
+            format = entry.format;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_gatt_statistic(const std::string& name, GattStatistic& statistic)
+{
+    static const struct
+    {
+        const char* name;
+        GattStatistic statistic;
+    } statistics[] = {{"last", GattStatistic::LAST},
+                      {"min", GattStatistic::MIN},
+                      {"max", GattStatistic::MAX},
+                      {"mean", GattStatistic::MEAN}};
+
+    for (const auto& entry : statistics)
+    {
+        if (name == entry.name)
+        {
+            statistic = entry.statistic;
+            return true;
+        }
+    }
+    return false;
+}
+
+gsize gatt_format_size(GattFormat format)
+{
+    switch (format)
+    {
+    case GattFormat::UINT8:
+    case GattFormat::INT8:
+        return 1;
+    case GattFormat::UINT16:
+    case GattFormat::INT16:
+        return 2;
+    case GattFormat::UINT32:
+    case GattFormat::INT32:
+    case GattFormat::FLOAT32:
+        return 4;
+    }
+    return 0;
+}
+
+bool encode_gatt_value(const GattCharacteristic& characteristic, const std::string& value, std::vector<guint8>& out)
+{
+    double number;
+    if (value == "true")
+    {
+        number = 1;
+    }
+    else if (value == "false")
+    {
+        number = 0;
+    }
+    else
+    {
+        char* end;
+        errno = 0;
+        number = std::strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0' || errno != 0 || !std::isfinite(number))
+            return false;
+    }
+
+    if (characteristic.scaled)
+        number /= characteristic.scale;
+
+    guint32 raw;
+    if (characteristic.format == GattFormat::FLOAT32)
+    {
+        const float f = static_cast<float>(number);
+        static_assert(sizeof(f) == sizeof(raw), "float must be 32 bits wide");
+        std::memcpy(&raw, &f, sizeof(raw));
+    }
+    else
+    {
+        double min = 0;
+        double max = 0;
+        switch (characteristic.format)
+        {
+        case GattFormat::UINT8:
+            max = G_MAXUINT8;
+            break;
+        case GattFormat::INT8:
+            min = G_MININT8;
+            max = G_MAXINT8;
+            break;
+        case GattFormat::UINT16:
+            max = G_MAXUINT16;
+            break;
+        case GattFormat::INT16:
+            min = G_MININT16;
+            max = G_MAXINT16;
+            break;
+        case GattFormat::UINT32:
+            max = G_MAXUINT32;
+            break;
+        case GattFormat::INT32:
+            min = G_MININT32;
+            max = G_MAXINT32;
+            break;
+        case GattFormat::FLOAT32:
+            break;
+        }
+
+        number = std::round(number);
+        if (number < min || number > max)
+            return false;
+
+        // Two's complement of negative values is what ends up on the wire
+        raw = number < 0 ? static_cast<guint32>(static_cast<gint32>(number)) : static_cast<guint32>(number);
+    }
+
+    const gsize size = gatt_format_size(characteristic.format);
+    out.assign(characteristic.offset + size, 0);
+    for (gsize i = 0; i < size; ++i)
+        out[characteristic.offset + i] = static_cast<guint8>(raw >> (8 * i));
+    return true;
+}
+
+bool gatt_already_connected(GError* error)
+{
+    gchar* name = g_dbus_error_get_remote_error(error);
+    const bool connected = name != NULL && !g_strcmp0(name, "org.bluez.Error.AlreadyConnected");
+    g_free(name);
+    return connected;
+}
+
+std::vector<std::string> find_characteristic_paths(GVariant* managed_objects, const std::string& device_path,
+                                                   const std::vector<GattCharacteristic>& characteristics)
+{
+    std::vector<std::string> paths(characteristics.size());
+
+    GVariantIter* objects;
+    const gchar* object;
+    GVariant* interfaces;
+    const std::string prefix = device_path + "/";
+
+    g_variant_get(managed_objects, "(a{oa{sa{sv}}})", &objects);
+    while (g_variant_iter_next(objects, "{&o@a{sa{sv}}}", &object, &interfaces))
+    {
+        GVariant* characteristic;
+        if (g_str_has_prefix(object, prefix.c_str()) &&
+            (characteristic = g_variant_lookup_value(interfaces, "org.bluez.GattCharacteristic1", NULL)) != NULL)
+        {
+            const gchar* uuid;
+            if (g_variant_lookup(characteristic, "UUID", "&s", &uuid))
+            {
+                for (gsize i = 0; i < paths.size(); ++i)
+                {
+                    if (!g_ascii_strcasecmp(uuid, characteristics[i].uuid.c_str()))
+                        paths[i] = object;
+                }
+            }
+            g_variant_unref(characteristic);
+        }
+        g_variant_unref(interfaces);
+    }
+    g_variant_iter_free(objects);
+
+    return paths;
+}
+
+}    // namespace wolkabout
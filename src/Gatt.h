@@ -0,0 +1,136 @@
+#ifndef GATT_H
+#define GATT_H
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Layout of a characteristic value. Multi-byte values are little endian as
+ * mandated by GATT.
+ */
+enum class GattFormat
+{
+    UINT8,
+    INT8,
+    UINT16,
+    INT16,
+    UINT32,
+    INT32,
+    FLOAT32
+};
+
+/**
+ * Statistic published for a characteristic whose notifications are
+ * aggregated over the readings interval.
+ */
+enum class GattStatistic
+{
+    LAST,
+    MIN,
+    MAX,
+    MEAN
+};
+
+struct GattCharacteristic
+{
+    std::string uuid;
+    std::string reference;
+    std::string name;
+    GattFormat format;
+    gsize offset;
+    bool scaled;
+    double scale;
+    GattStatistic statistic;
+};
+
+struct GattDevice
+{
+    std::string key;
+    std::string address;
+    std::string adapter;
+    bool notify;
+    unsigned period;
+    std::vector<GattCharacteristic> characteristics;
+    std::vector<GattCharacteristic> actuators;
+};
+
+bool parse_gatt_format(const std::string& name, GattFormat& format);
+
+bool parse_gatt_statistic(const std::string& name, GattStatistic& statistic);
+
+gsize gatt_format_size(GattFormat format);
+
+/**
+ * Encodes an actuator command into the characteristic's layout, undoing its
+ * scale. Accepts numbers and "true"/"false"; fails on values that do not fit
+ * the format. The encoded value is written at `offset` with leading bytes
+ * zeroed.
+ */
+bool encode_gatt_value(const GattCharacteristic& characteristic, const std::string& value, std::vector<guint8>& out);
+
+/**
+ * True for the error BlueZ returns when connecting to a device that is
+ * already connected.
+ */
+bool gatt_already_connected(GError* error);
+
+/**
+ * Maps each characteristic to its object path below `device_path` in a
+ * GetManagedObjects reply. Characteristics that were not found map to an
+ * empty string.
+ */
+std::vector<std::string> find_characteristic_paths(GVariant* managed_objects, const std::string& device_path,
+                                                   const std::vector<GattCharacteristic>& characteristics);
+
+template <typename Sink>
+bool decode_gatt_value(const GattCharacteristic& characteristic, const guint8* data, gsize size, const Sink& sink)
+{
+    if (characteristic.offset + gatt_format_size(characteristic.format) > size)
+        return false;
+
+    const guint8* p = data + characteristic.offset;
+    guint32 raw = 0;
+    for (gsize i = gatt_format_size(characteristic.format); i-- > 0;)
+        raw = (raw << 8) | p[i];
+
+    double value = 0;
+    switch (characteristic.format)
+    {
+    case GattFormat::UINT8:
+    case GattFormat::UINT16:
+    case GattFormat::UINT32:
+        value = raw;
+        break;
+    case GattFormat::INT8:
+        value = static_cast<gint8>(raw);
+        break;
+    case GattFormat::INT16:
+        value = static_cast<gint16>(raw);
+        break;
+    case GattFormat::INT32:
+        value = static_cast<gint32>(raw);
+        break;
+    case GattFormat::FLOAT32:
+    {
+        float f;
+        static_assert(sizeof(f) == sizeof(raw), "float must be 32 bits wide");
+        std::memcpy(&f, &raw, sizeof(f));
+        value = f;
+        break;
+    }
+    }
+
+    if (!characteristic.scaled && characteristic.format != GattFormat::FLOAT32)
+        sink(characteristic.reference.c_str(), static_cast<long long>(value));
+    else
+        sink(characteristic.reference.c_str(), value * characteristic.scale);
+    return true;
+}
+
+}    // namespace wolkabout
+#endif
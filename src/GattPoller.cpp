@@ -0,0 +1,562 @@
+#include "GattPoller.h"
+#include "Bus.h"
+#include "core/utilities/Logger.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+namespace
+{
+const int CONNECT_TIMEOUT_MS = 30000;
+const int CALL_TIMEOUT_MS = 10000;
+const unsigned DISCOVERY_ATTEMPTS = 5;
+const guint DISCOVERY_RETRY_MS = 1000;
+const gint64 BACKOFF_BASE = 10 * G_USEC_PER_SEC;
+const gint64 BACKOFF_MAX = 300 * G_USEC_PER_SEC;
+const unsigned BACKOFF_MAX_SHIFT = 10;
+
+class StringSink
+{
+public:
+    explicit StringSink(std::string& target) : value(target) {}
+
+    template <typename T> void operator()(const char* reference, T decoded) const
+    {
+        (void)reference;
+        value = std::to_string(decoded);
+    }
+
+private:
+    std::string& value;
+};
+
+bool has_path(const std::vector<std::string>& paths)
+{
+    return std::any_of(paths.begin(), paths.end(), [](const std::string& path) { return !path.empty(); });
+}
+}    // namespace
+
+GattPoller::GattPoller(Wolk& wolk_instance, ReadingOutlet& reading_outlet, ConnectionPool& connection_pool,
+                       std::string adapter)
+: wolk(wolk_instance), outlet(reading_outlet), pool(connection_pool), adapter_path(std::move(adapter))
+{
+}
+
+void GattPoller::add_device(const GattDevice& device, bool streamed)
+{
+    std::string address = device.address;
+    std::replace(address.begin(), address.end(), ':', '_');
+
+    Entry entry{device, streamed, adapter_path + "/dev_" + address, {}, {}, false, G_MAXINT64, 0, false, {}};
+    entry.actuators.resize(device.actuators.size(), ActuatorState{"", "", false, false, false});
+
+    index[device.key] = entries.size();
+    entries.push_back(entry);
+}
+
+bool GattPoller::empty() const
+{
+    return entries.empty();
+}
+
+void GattPoller::start()
+{
+    const gint64 now = g_get_monotonic_time();
+    const gint64 count = static_cast<gint64>(entries.size());
+
+    // Spread the first round over each device's period so they do not all connect at once
+    for (gsize i = 0; i < entries.size(); ++i)
+    {
+        const gint64 period = static_cast<gint64>(entries[i].device.period) * G_USEC_PER_SEC;
+        entries[i].due = now + period * static_cast<gint64>(i) / count;
+        deadlines.push(Deadline(entries[i].due, i));
+    }
+
+    g_timeout_add_seconds(1, GattPoller::tick, this);
+}
+
+void GattPoller::reset()
+{
+    const gint64 now = g_get_monotonic_time();
+    for (gsize i = 0; i < entries.size(); ++i)
+    {
+        Entry& entry = entries[i];
+        entry.resolved = false;
+        entry.failures = 0;
+
+        // Running sessions fail on their own and back off from a clean slate
+        if (!entry.busy && entry.due > now && !entry.device.characteristics.empty())
+            reschedule(i, now);
+    }
+    schedule();
+}
+
+bool GattPoller::queue_write(const std::string& key, const std::string& reference, const std::string& value)
+{
+    const auto it = index.find(key);
+    if (it == index.end())
+        return false;
+
+    const GattDevice& device = entries[it->second].device;
+    for (gsize i = 0; i < device.actuators.size(); ++i)
+    {
+        if (device.actuators[i].reference != reference)
+            continue;
+
+        bool wake_up;
+        {
+            std::lock_guard<std::mutex> lock(actuator_lock);
+            ActuatorState& state = entries[it->second].actuators[i];
+            state.pending = value;
+            state.has_pending = true;
+
+            // Commands arriving before the device is served only replace the pending value
+            wake_up = write_requests.empty();
+            write_requests.push_back(it->second);
+        }
+
+        if (wake_up)
+            g_idle_add(GattPoller::wake, this);
+        return true;
+    }
+    return false;
+}
+
+ActuatorStatus GattPoller::actuator_status(const std::string& key, const std::string& reference)
+{
+    const auto it = index.find(key);
+    if (it != index.end())
+    {
+        const GattDevice& device = entries[it->second].device;
+        for (gsize i = 0; i < device.actuators.size(); ++i)
+        {
+            if (device.actuators[i].reference != reference)
+                continue;
+
+            std::lock_guard<std::mutex> lock(actuator_lock);
+            const ActuatorState& state = entries[it->second].actuators[i];
+            if (state.has_pending || state.in_flight)
+                return ActuatorStatus(state.value, ActuatorStatus::State::BUSY);
+            if (state.failed)
+                return ActuatorStatus(state.value, ActuatorStatus::State::ERROR);
+            return ActuatorStatus(state.value, ActuatorStatus::State::READY);
+        }
+    }
+    return ActuatorStatus("", ActuatorStatus::State::ERROR);
+}
+
+gboolean GattPoller::tick(gpointer user_data)
+{
+    static_cast<GattPoller*>(user_data)->schedule();
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean GattPoller::wake(gpointer user_data)
+{
+    GattPoller* poller = static_cast<GattPoller*>(user_data);
+
+    std::vector<gsize> requests;
+    {
+        std::lock_guard<std::mutex> lock(poller->actuator_lock);
+        requests.swap(poller->write_requests);
+    }
+
+    const gint64 now = g_get_monotonic_time();
+    for (gsize entry : requests)
+    {
+        // Busy devices pick up their pending writes when the current session finishes
+        if (!poller->entries[entry].busy && poller->entries[entry].due > now)
+            poller->reschedule(entry, now);
+    }
+
+    poller->schedule();
+    return G_SOURCE_REMOVE;
+}
+
+void GattPoller::reschedule(gsize entry, gint64 due)
+{
+    // Superseded deadlines stay queued and are skipped when they come up
+    entries[entry].due = due;
+    if (due != G_MAXINT64)
+        deadlines.push(Deadline(due, entry));
+}
+
+void GattPoller::schedule()
+{
+    const gint64 now = g_get_monotonic_time();
+
+    while (!deadlines.empty() && deadlines.top().first <= now)
+    {
+        const Deadline deadline = deadlines.top();
+        const Entry& entry = entries[deadline.second];
+        if (entry.busy || entry.due != deadline.first)
+        {
+            deadlines.pop();
+            continue;
+        }
+
+        if (!pool.try_acquire())
+            break;
+
+        deadlines.pop();
+        begin(deadline.second);
+    }
+}
+
+void GattPoller::begin(gsize entry)
+{
+    Entry& e = entries[entry];
+    Session* session = new Session{this, entry, {}, 0, 0, false, false};
+
+    // Writes go first so commands are not delayed by a slow read
+    {
+        std::lock_guard<std::mutex> lock(actuator_lock);
+        for (gsize i = 0; i < e.actuators.size(); ++i)
+        {
+            ActuatorState& state = e.actuators[i];
+            if (state.has_pending)
+            {
+                session->operations.push_back(Operation{true, i, state.pending});
+                state.has_pending = false;
+                state.in_flight = true;
+            }
+            else if (state.value.empty())
+            {
+                session->operations.push_back(Operation{false, i, ""});
+            }
+        }
+    }
+
+    for (gsize i = 0; i < e.device.characteristics.size(); ++i)
+        session->operations.push_back(Operation{false, e.actuators.size() + i, ""});
+
+    e.busy = true;
+    connect(session);
+}
+
+void GattPoller::connect(Session* session)
+{
+    g_dbus_connection_call(Bus::connection(), "org.bluez", entries[session->entry].path.c_str(),
+                           "org.bluez.Device1", "Connect", NULL, NULL, G_DBUS_CALL_FLAGS_NONE, CONNECT_TIMEOUT_MS,
+                           NULL, GattPoller::connected, session);
+}
+
+void GattPoller::connected(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    Session* session = static_cast<Session*>(user_data);
+    GattPoller* poller = session->poller;
+    GError* error = NULL;
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+    {
+        if (!gatt_already_connected(error))
+        {
+            LOG(DEBUG) << "Unable to connect to " << poller->entries[session->entry].device.key << ": "
+                       << error->message;
+            g_error_free(error);
+            poller->finish(session, false);
+            return;
+        }
+        g_error_free(error);
+
+        // The stream holds the connection and its slot
+        if (poller->entries[session->entry].streamed)
+        {
+            session->shared = true;
+            poller->pool.release();
+        }
+    }
+    else
+    {
+        g_variant_unref(reply);
+    }
+
+    if (!poller->entries[session->entry].resolved)
+        poller->discover(session);
+    else
+        poller->run_next(session);
+}
+
+void GattPoller::discover(Session* session)
+{
+    ++session->discovery_attempts;
+    g_dbus_connection_call(Bus::connection(), "org.bluez", "/", "org.freedesktop.DBus.ObjectManager",
+                           "GetManagedObjects", NULL, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE,
+                           CALL_TIMEOUT_MS, NULL, GattPoller::discovered, session);
+}
+
+gboolean GattPoller::discover_later(gpointer user_data)
+{
+    Session* session = static_cast<Session*>(user_data);
+    session->poller->discover(session);
+    return G_SOURCE_REMOVE;
+}
+
+void GattPoller::discovered(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    Session* session = static_cast<Session*>(user_data);
+    GattPoller* poller = session->poller;
+    Entry& entry = poller->entries[session->entry];
+    GError* error = NULL;
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+    {
+        LOG(DEBUG) << "Unable to discover characteristics of " << entry.device.key << ": " << error->message;
+        g_error_free(error);
+        poller->disconnect(session);
+        return;
+    }
+
+    entry.sensor_paths = find_characteristic_paths(reply, entry.path, entry.device.characteristics);
+    entry.actuator_paths = find_characteristic_paths(reply, entry.path, entry.device.actuators);
+    g_variant_unref(reply);
+
+    if (!has_path(entry.sensor_paths) && !has_path(entry.actuator_paths))
+    {
+        // Services are resolved asynchronously after the connection is established
+        if (session->discovery_attempts < DISCOVERY_ATTEMPTS)
+            g_timeout_add(DISCOVERY_RETRY_MS, GattPoller::discover_later, session);
+        else
+            poller->disconnect(session);
+        return;
+    }
+
+    entry.resolved = true;
+    poller->run_next(session);
+}
+
+void GattPoller::run_next(Session* session)
+{
+    const Entry& entry = entries[session->entry];
+    const gsize actuators = entry.device.actuators.size();
+
+    for (; session->next < session->operations.size(); ++session->next)
+    {
+        const Operation& operation = session->operations[session->next];
+        const std::string& path = operation.index < actuators ? entry.actuator_paths[operation.index] :
+                                                                entry.sensor_paths[operation.index - actuators];
+        if (path.empty())
+        {
+            if (operation.write)
+            {
+                LOG(WARN) << "Characteristic of actuator " << entry.device.actuators[operation.index].reference
+                          << " not found on " << entry.device.key;
+                write_completed(session, false);
+            }
+            continue;
+        }
+
+        if (operation.write)
+        {
+            std::vector<guint8> bytes;
+            if (!encode_gatt_value(entry.device.actuators[operation.index], operation.value, bytes))
+            {
+                LOG(WARN) << "Value '" << operation.value << "' does not fit actuator "
+                          << entry.device.actuators[operation.index].reference << " of " << entry.device.key;
+                write_completed(session, false);
+                continue;
+            }
+
+            GVariant* value = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, bytes.data(), bytes.size(), 1);
+            g_dbus_connection_call(Bus::connection(), "org.bluez", path.c_str(), "org.bluez.GattCharacteristic1",
+                                   "WriteValue", g_variant_new("(@aya{sv})", value, NULL), NULL,
+                                   G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, GattPoller::write_done, session);
+        }
+        else
+        {
+            g_dbus_connection_call(Bus::connection(), "org.bluez", path.c_str(), "org.bluez.GattCharacteristic1",
+                                   "ReadValue", g_variant_new("(a{sv})", NULL), G_VARIANT_TYPE("(ay)"),
+                                   G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, GattPoller::read_done, session);
+        }
+        return;
+    }
+
+    disconnect(session);
+}
+
+void GattPoller::read_done(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    Session* session = static_cast<Session*>(user_data);
+    GattPoller* poller = session->poller;
+    Entry& entry = poller->entries[session->entry];
+    const gsize index = session->operations[session->next].index;
+    const gsize actuators = entry.device.actuators.size();
+    const GattCharacteristic& characteristic =
+      index < actuators ? entry.device.actuators[index] : entry.device.characteristics[index - actuators];
+    GError* error = NULL;
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+    {
+        LOG(DEBUG) << "Unable to read " << characteristic.uuid << " of " << entry.device.key << ": "
+                   << error->message;
+        g_error_free(error);
+
+        // Object paths are not stable across service changes, look them up again next time
+        entry.resolved = false;
+        poller->disconnect(session);
+        return;
+    }
+
+    GVariant* value;
+    gsize size;
+    g_variant_get(reply, "(@ay)", &value);
+    const guint8* data = static_cast<const guint8*>(g_variant_get_fixed_array(value, &size, 1));
+
+    std::string current;
+    if (index < actuators)
+    {
+        if (decode_gatt_value(characteristic, data, size, StringSink(current)))
+        {
+            {
+                std::lock_guard<std::mutex> lock(poller->actuator_lock);
+                ActuatorState& state = entry.actuators[index];
+                if (!state.has_pending && !state.in_flight)
+                    state.value = current;
+            }
+            poller->wolk.publishActuatorStatus(entry.device.key, characteristic.reference);
+        }
+        session->succeeded = true;
+    }
+    else if (decode_gatt_value(characteristic, data, size, ReadingSink(poller->outlet, entry.device.key)))
+    {
+        session->succeeded = true;
+    }
+
+    g_variant_unref(value);
+    g_variant_unref(reply);
+
+    ++session->next;
+    poller->run_next(session);
+}
+
+void GattPoller::write_done(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    Session* session = static_cast<Session*>(user_data);
+    GattPoller* poller = session->poller;
+    const Entry& entry = poller->entries[session->entry];
+    GError* error = NULL;
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+    {
+        LOG(WARN) << "Unable to write actuator "
+                  << entry.device.actuators[session->operations[session->next].index].reference << " of "
+                  << entry.device.key << ": " << error->message;
+        g_error_free(error);
+        poller->write_completed(session, false);
+    }
+    else
+    {
+        g_variant_unref(reply);
+        session->succeeded = true;
+        poller->write_completed(session, true);
+    }
+
+    ++session->next;
+    poller->run_next(session);
+}
+
+void GattPoller::write_completed(Session* session, bool success)
+{
+    const Entry& entry = entries[session->entry];
+    const Operation& operation = session->operations[session->next];
+
+    {
+        std::lock_guard<std::mutex> lock(actuator_lock);
+        ActuatorState& state = entries[session->entry].actuators[operation.index];
+        state.in_flight = false;
+        state.failed = !success;
+        if (success)
+            state.value = operation.value;
+    }
+
+    wolk.publishActuatorStatus(entry.device.key, entry.device.actuators[operation.index].reference);
+}
+
+void GattPoller::disconnect(Session* session)
+{
+    // Shared connections stay open so the stream keeps receiving values
+    if (session->shared)
+    {
+        finish(session, session->succeeded);
+        return;
+    }
+
+    g_dbus_connection_call(Bus::connection(), "org.bluez", entries[session->entry].path.c_str(),
+                           "org.bluez.Device1", "Disconnect", NULL, NULL, G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS,
+                           NULL, GattPoller::disconnected, session);
+}
+
+void GattPoller::disconnected(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    Session* session = static_cast<Session*>(user_data);
+    GError* error = NULL;
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+        g_error_free(error);
+    else
+        g_variant_unref(reply);
+
+    session->poller->finish(session, session->succeeded);
+}
+
+void GattPoller::finish(Session* session, bool success)
+{
+    Entry& entry = entries[session->entry];
+    const gint64 now = g_get_monotonic_time();
+    const gint64 period = static_cast<gint64>(entry.device.period) * G_USEC_PER_SEC;
+
+    // Writes that were not attempted are retried unless a newer command replaced them
+    bool pending = false;
+    {
+        std::lock_guard<std::mutex> lock(actuator_lock);
+        for (gsize i = session->next; i < session->operations.size(); ++i)
+        {
+            const Operation& operation = session->operations[i];
+            if (!operation.write || !entry.actuators[operation.index].in_flight)
+                continue;
+
+            ActuatorState& state = entry.actuators[operation.index];
+            state.in_flight = false;
+            if (!state.has_pending)
+            {
+                state.pending = operation.value;
+                state.has_pending = true;
+            }
+        }
+
+        for (const ActuatorState& state : entry.actuators)
+            pending = pending || state.has_pending;
+    }
+
+    gint64 due;
+    if (success)
+    {
+        entry.failures = 0;
+        due = pending ? now : entry.device.characteristics.empty() ? G_MAXINT64 : now + period;
+    }
+    else
+    {
+        const unsigned shift = std::min(entry.failures, BACKOFF_MAX_SHIFT);
+        gint64 backoff = BACKOFF_BASE << shift;
+        if (!entry.device.characteristics.empty())
+            backoff = std::min(period, backoff);
+        ++entry.failures;
+        due = now + std::min(BACKOFF_MAX, backoff) + g_random_int_range(0, G_USEC_PER_SEC);
+    }
+
+    entry.busy = false;
+    reschedule(session->entry, due);
+    if (!session->shared)
+        pool.release();
+    delete session;
+
+    schedule();
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,148 @@
+#ifndef GATTPOLLER_H
+#define GATTPOLLER_H
+
+#include "AdvertisementDecoder.h"
+#include "ConnectionPool.h"
+#include "Gatt.h"
+#include "Wolk.h"
+#include "core/model/ActuatorStatus.h"
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Periodically connects to devices through one adapter, writes pending
+ * actuator commands, reads the configured characteristics and disconnects.
+ * Devices are served earliest deadline first while the adapter's connection
+ * pool has room, and failed devices are retried with exponential backoff so
+ * unreachable devices do not occupy connection slots.
+ *
+ * Actuator commands only replace the pending value of their actuator, so a
+ * burst of commands results in a single write of the latest value, and all
+ * pending writes of a device are done over one connection.
+ */
+class GattPoller
+{
+public:
+    GattPoller(Wolk& wolk, ReadingOutlet& outlet, ConnectionPool& pool, std::string adapter_path);
+
+    /**
+     * `streamed` devices are also kept connected by a GattStream. A session
+     * that finds such a device connected shares the stream's connection and
+     * connection slot instead of holding and closing its own.
+     */
+    void add_device(const GattDevice& device, bool streamed = false);
+
+    bool empty() const;
+
+    void start();
+
+    /**
+     * Looks characteristics up again and polls all devices right away after
+     * bluetoothd restarted.
+     */
+    void reset();
+
+    /**
+     * Safe to call from any thread. Returns false when the device has no such
+     * actuator.
+     */
+    bool queue_write(const std::string& key, const std::string& reference, const std::string& value);
+
+    /**
+     * Safe to call from any thread.
+     */
+    ActuatorStatus actuator_status(const std::string& key, const std::string& reference);
+
+private:
+    struct ActuatorState
+    {
+        std::string value;
+        std::string pending;
+        bool has_pending;
+        bool in_flight;
+        bool failed;
+    };
+
+    struct Entry
+    {
+        GattDevice device;
+        bool streamed;
+        std::string path;
+        std::vector<std::string> sensor_paths;
+        std::vector<std::string> actuator_paths;
+        bool resolved;
+        gint64 due;
+        unsigned failures;
+        bool busy;
+        std::vector<ActuatorState> actuators;
+    };
+
+    struct Operation
+    {
+        bool write;
+        gsize index;
+        std::string value;
+    };
+
+    struct Session
+    {
+        GattPoller* poller;
+        gsize entry;
+        std::vector<Operation> operations;
+        gsize next;
+        unsigned discovery_attempts;
+        bool succeeded;
+        bool shared;
+    };
+
+    typedef std::pair<gint64, gsize> Deadline;
+
+    static gboolean tick(gpointer user_data);
+    static gboolean wake(gpointer user_data);
+    void schedule();
+    void reschedule(gsize entry, gint64 due);
+
+    void begin(gsize entry);
+
+    void connect(Session* session);
+    static void connected(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    void discover(Session* session);
+    static gboolean discover_later(gpointer user_data);
+    static void discovered(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    void run_next(Session* session);
+    static void read_done(GObject* source, GAsyncResult* result, gpointer user_data);
+    static void write_done(GObject* source, GAsyncResult* result, gpointer user_data);
+    void write_completed(Session* session, bool success);
+
+    void disconnect(Session* session);
+    static void disconnected(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    void finish(Session* session, bool success);
+
+    Wolk& wolk;
+    ReadingOutlet& outlet;
+    ConnectionPool& pool;
+    std::string adapter_path;
+
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, gsize> index;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines;
+
+    std::mutex actuator_lock;
+    std::vector<gsize> write_requests;
+};
+
+}    // namespace wolkabout
+#endif
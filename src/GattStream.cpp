@@ -0,0 +1,422 @@
+#include "GattStream.h"
+#include "Bus.h"
+#include "core/utilities/Logger.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+namespace
+{
+const int CONNECT_TIMEOUT_MS = 30000;
+const int CALL_TIMEOUT_MS = 10000;
+const unsigned DISCOVERY_ATTEMPTS = 5;
+const guint DISCOVERY_RETRY_MS = 1000;
+const gint64 BACKOFF_BASE = 5 * G_USEC_PER_SEC;
+const gint64 BACKOFF_MAX = 300 * G_USEC_PER_SEC;
+const unsigned BACKOFF_MAX_SHIFT = 10;
+
+template <typename Aggregate> class AggregateSink
+{
+public:
+    explicit AggregateSink(Aggregate& target) : aggregate(target) {}
+
+    template <typename T> void operator()(const char* reference, T value) const
+    {
+        (void)reference;
+        aggregate.add(static_cast<double>(value));
+    }
+
+private:
+    Aggregate& aggregate;
+};
+
+void ignore_reply(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    (void)user_data;
+    GError* error = NULL;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+        g_error_free(error);
+    else
+        g_variant_unref(reply);
+}
+}    // namespace
+
+void GattStream::Aggregate::add(double value)
+{
+    if (count == 0 || value < min)
+        min = value;
+    if (count == 0 || value > max)
+        max = value;
+    last = value;
+    sum += value;
+    ++count;
+}
+
+GattStream::GattStream(Wolk& wolk_instance, ReadingOutlet& reading_outlet, ConnectionPool& connection_pool,
+                       std::string adapter, unsigned interval)
+: wolk(wolk_instance)
+, outlet(reading_outlet)
+, pool(connection_pool)
+, adapter_path(std::move(adapter))
+, flush_interval(interval)
+{
+}
+
+void GattStream::add_device(const GattDevice& device)
+{
+    std::string address = device.address;
+    std::replace(address.begin(), address.end(), ':', '_');
+
+    Entry entry{device, adapter_path + "/dev_" + address, {}, {}, State::IDLE, 0, 0, 0, 0, 0, 0};
+    entry.aggregates.resize(device.characteristics.size(), Aggregate{0, 0, 0, 0, 0});
+    entries.push_back(entry);
+}
+
+bool GattStream::empty() const
+{
+    return entries.empty();
+}
+
+void GattStream::start()
+{
+    g_timeout_add_seconds(1, GattStream::tick, this);
+    g_timeout_add_seconds(flush_interval, GattStream::flush, this);
+}
+
+gboolean GattStream::flush(gpointer user_data)
+{
+    GattStream* stream = static_cast<GattStream*>(user_data);
+    bool flushed = false;
+
+    for (auto& entry : stream->entries)
+    {
+        for (gsize i = 0; i < entry.aggregates.size(); ++i)
+        {
+            Aggregate& aggregate = entry.aggregates[i];
+            if (aggregate.count == 0)
+                continue;
+
+            const GattCharacteristic& characteristic = entry.device.characteristics[i];
+            double value = aggregate.last;
+            switch (characteristic.statistic)
+            {
+            case GattStatistic::LAST:
+                value = aggregate.last;
+                break;
+            case GattStatistic::MIN:
+                value = aggregate.min;
+                break;
+            case GattStatistic::MAX:
+                value = aggregate.max;
+                break;
+            case GattStatistic::MEAN:
+                value = aggregate.sum / static_cast<double>(aggregate.count);
+                break;
+            }
+
+            stream->outlet.add(entry.device.key, characteristic.reference, value);
+            aggregate = Aggregate{0, 0, 0, 0, 0};
+            flushed = true;
+        }
+    }
+
+    if (flushed)
+        stream->wolk.publish();
+    return G_SOURCE_CONTINUE;
+}
+
+void GattStream::reset()
+{
+    for (auto& entry : entries)
+    {
+        if (entry.state != State::IDLE)
+        {
+            for (guint subscription : entry.subscriptions)
+                g_dbus_connection_signal_unsubscribe(Bus::connection(), subscription);
+            entry.subscriptions.clear();
+
+            // Replies still pending for the old connection are discarded by the generation check
+            entry.state = State::IDLE;
+            ++entry.generation;
+            pool.release();
+        }
+        entry.due = 0;
+        entry.failures = 0;
+    }
+}
+
+gboolean GattStream::tick(gpointer user_data)
+{
+    GattStream* stream = static_cast<GattStream*>(user_data);
+    const gint64 now = g_get_monotonic_time();
+
+    for (gsize i = 0; i < stream->entries.size(); ++i)
+    {
+        const Entry& entry = stream->entries[i];
+        if (entry.state == State::IDLE && entry.due <= now && stream->pool.try_acquire())
+            stream->connect(i);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+void GattStream::connect(gsize entry)
+{
+    entries[entry].state = State::CONNECTING;
+    entries[entry].discovery_attempts = 0;
+
+    g_dbus_connection_call(Bus::connection(), "org.bluez", entries[entry].path.c_str(), "org.bluez.Device1",
+                           "Connect", NULL, NULL, G_DBUS_CALL_FLAGS_NONE, CONNECT_TIMEOUT_MS, NULL,
+                           GattStream::connected, new Call{this, entry, entries[entry].generation});
+}
+
+void GattStream::connected(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    Call* call = static_cast<Call*>(user_data);
+    GattStream* stream = call->stream;
+    GError* error = NULL;
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (stream->entries[call->entry].generation != call->generation)
+    {
+        // The stream was reset while connecting
+        if (error != NULL)
+            g_error_free(error);
+        else
+            g_variant_unref(reply);
+        delete call;
+        return;
+    }
+
+    if (error != NULL)
+    {
+        // The poller may be connected to write actuators
+        if (!gatt_already_connected(error))
+        {
+            LOG(DEBUG) << "Unable to connect to " << stream->entries[call->entry].device.key << ": "
+                       << error->message;
+            g_error_free(error);
+            stream->drop(call->entry);
+            delete call;
+            return;
+        }
+        g_error_free(error);
+    }
+    else
+    {
+        g_variant_unref(reply);
+    }
+
+    Entry& entry = stream->entries[call->entry];
+    entry.subscriptions.push_back(g_dbus_connection_signal_subscribe(
+      Bus::connection(), "org.bluez", "org.freedesktop.DBus.Properties", "PropertiesChanged",
+      entry.path.c_str(), "org.bluez.Device1", G_DBUS_SIGNAL_FLAGS_NONE, GattStream::device_changed,
+      new Subscription{stream, call->entry, 0}, GattStream::free_subscription));
+
+    stream->discover(call);
+}
+
+void GattStream::discover(Call* call)
+{
+    ++entries[call->entry].discovery_attempts;
+    g_dbus_connection_call(Bus::connection(), "org.bluez", "/", "org.freedesktop.DBus.ObjectManager",
+                           "GetManagedObjects", NULL, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE,
+                           CALL_TIMEOUT_MS, NULL, GattStream::discovered, call);
+}
+
+gboolean GattStream::discover_later(gpointer user_data)
+{
+    Call* call = static_cast<Call*>(user_data);
+    call->stream->discover(call);
+    return G_SOURCE_REMOVE;
+}
+
+void GattStream::discovered(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    Call* call = static_cast<Call*>(user_data);
+    GattStream* stream = call->stream;
+    Entry& entry = stream->entries[call->entry];
+    GError* error = NULL;
+
+    if (entry.state != State::CONNECTING || entry.generation != call->generation)
+    {
+        // The device disconnected while its services were being looked up
+        GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+        if (error != NULL)
+            g_error_free(error);
+        else
+            g_variant_unref(reply);
+        delete call;
+        return;
+    }
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+    {
+        LOG(DEBUG) << "Unable to discover characteristics of " << entry.device.key << ": " << error->message;
+        g_error_free(error);
+        stream->drop(call->entry);
+        delete call;
+        return;
+    }
+
+    const std::vector<std::string> paths = find_characteristic_paths(reply, entry.path, entry.device.characteristics);
+    const bool found = std::any_of(paths.begin(), paths.end(), [](const std::string& path) { return !path.empty(); });
+    g_variant_unref(reply);
+
+    if (!found)
+    {
+        if (entry.discovery_attempts < DISCOVERY_ATTEMPTS)
+        {
+            g_timeout_add(DISCOVERY_RETRY_MS, GattStream::discover_later, call);
+            return;
+        }
+
+        stream->drop(call->entry);
+        delete call;
+        return;
+    }
+
+    stream->subscribe(call->entry, paths);
+    delete call;
+}
+
+void GattStream::subscribe(gsize entry, const std::vector<std::string>& paths)
+{
+    Entry& e = entries[entry];
+    e.pending_notify = 0;
+    e.notifying = 0;
+
+    for (gsize i = 0; i < paths.size(); ++i)
+    {
+        if (paths[i].empty())
+            continue;
+
+        e.subscriptions.push_back(g_dbus_connection_signal_subscribe(
+          Bus::connection(), "org.bluez", "org.freedesktop.DBus.Properties", "PropertiesChanged",
+          paths[i].c_str(), "org.bluez.GattCharacteristic1", G_DBUS_SIGNAL_FLAGS_NONE, GattStream::value_changed,
+          new Subscription{this, entry, i}, GattStream::free_subscription));
+
+        g_dbus_connection_call(Bus::connection(), "org.bluez", paths[i].c_str(), "org.bluez.GattCharacteristic1",
+                               "StartNotify", NULL, NULL, G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL,
+                               GattStream::notify_started, new NotifyCall{this, entry, i, e.generation});
+        ++e.pending_notify;
+    }
+
+    e.state = State::STREAMING;
+    e.failures = 0;
+    LOG(INFO) << "Streaming notifications of " << e.device.key;
+}
+
+void GattStream::notify_started(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    NotifyCall* call = static_cast<NotifyCall*>(user_data);
+    GattStream* stream = call->stream;
+    Entry& entry = stream->entries[call->entry];
+    GError* error = NULL;
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (entry.generation != call->generation)
+    {
+        // The device was dropped while notifications were being enabled
+        if (error != NULL)
+            g_error_free(error);
+        else
+            g_variant_unref(reply);
+        delete call;
+        return;
+    }
+
+    if (error != NULL)
+    {
+        LOG(WARN) << "Unable to enable notifications of " << entry.device.characteristics[call->characteristic].uuid
+                  << " on " << entry.device.key << ": " << error->message;
+        g_error_free(error);
+    }
+    else
+    {
+        g_variant_unref(reply);
+        ++entry.notifying;
+    }
+
+    // Nothing will be notified, the connection slot goes back to the pool
+    if (--entry.pending_notify == 0 && entry.notifying == 0)
+        stream->drop(call->entry);
+    delete call;
+}
+
+void GattStream::value_changed(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                               const gchar* interface, const gchar* signal, GVariant* parameters, gpointer user_data)
+{
+    (void)connection;
+    (void)sender;
+    (void)path;
+    (void)interface;
+    (void)signal;
+
+    const Subscription* subscription = static_cast<const Subscription*>(user_data);
+    Entry& entry = subscription->stream->entries[subscription->entry];
+
+    GVariant* changed = g_variant_get_child_value(parameters, 1);
+    GVariant* value = g_variant_lookup_value(changed, "Value", G_VARIANT_TYPE_BYTESTRING);
+    if (value != NULL)
+    {
+        gsize size;
+        const guint8* data = static_cast<const guint8*>(g_variant_get_fixed_array(value, &size, 1));
+        decode_gatt_value(entry.device.characteristics[subscription->characteristic], data, size,
+                          AggregateSink<Aggregate>(entry.aggregates[subscription->characteristic]));
+        g_variant_unref(value);
+    }
+    g_variant_unref(changed);
+}
+
+void GattStream::device_changed(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                const gchar* interface, const gchar* signal, GVariant* parameters, gpointer user_data)
+{
+    (void)connection;
+    (void)sender;
+    (void)path;
+    (void)interface;
+    (void)signal;
+
+    const Subscription* subscription = static_cast<const Subscription*>(user_data);
+
+    GVariant* changed = g_variant_get_child_value(parameters, 1);
+    gboolean connected;
+    if (g_variant_lookup(changed, "Connected", "b", &connected) && !connected)
+    {
+        LOG(INFO) << "Lost connection to " << subscription->stream->entries[subscription->entry].device.key;
+        subscription->stream->drop(subscription->entry);
+    }
+    g_variant_unref(changed);
+}
+
+void GattStream::free_subscription(gpointer user_data)
+{
+    delete static_cast<Subscription*>(user_data);
+}
+
+void GattStream::drop(gsize entry)
+{
+    Entry& e = entries[entry];
+    if (e.state == State::IDLE)
+        return;
+
+    for (guint subscription : e.subscriptions)
+        g_dbus_connection_signal_unsubscribe(Bus::connection(), subscription);
+    e.subscriptions.clear();
+
+    g_dbus_connection_call(Bus::connection(), "org.bluez", e.path.c_str(), "org.bluez.Device1", "Disconnect",
+                           NULL, NULL, G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT_MS, NULL, ignore_reply, NULL);
+
+    const unsigned shift = std::min(e.failures, BACKOFF_MAX_SHIFT);
+    e.due = g_get_monotonic_time() + std::min(BACKOFF_MAX, BACKOFF_BASE << shift);
+    ++e.failures;
+    e.state = State::IDLE;
+    ++e.generation;
+
+    pool.release();
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,130 @@
+#ifndef GATTSTREAM_H
+#define GATTSTREAM_H
+
+#include "ConnectionPool.h"
+#include "Gatt.h"
+#include "ReadingOutlet.h"
+#include "Wolk.h"
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Keeps devices connected and subscribed to notifications of their
+ * configured characteristics. Notified values are decoded in the signal
+ * handler and folded into per-interval statistics, which are handed to Wolk
+ * every `interval` seconds so a high notification rate does not turn into one
+ * reading per notification. Lost connections are re-established with backoff,
+ * and so are devices none of whose characteristics could be subscribed to, so
+ * they do not keep their connection slot.
+ */
+class GattStream
+{
+public:
+    GattStream(Wolk& wolk, ReadingOutlet& outlet, ConnectionPool& pool, std::string adapter_path, unsigned interval);
+
+    void add_device(const GattDevice& device);
+
+    bool empty() const;
+
+    void start();
+
+    /**
+     * Forgets all connections after bluetoothd restarted, devices are
+     * reconnected on the next tick.
+     */
+    void reset();
+
+private:
+    enum class State
+    {
+        IDLE,
+        CONNECTING,
+        STREAMING
+    };
+
+    struct Aggregate
+    {
+        guint64 count;
+        double last;
+        double min;
+        double max;
+        double sum;
+
+        void add(double value);
+    };
+
+    struct Entry
+    {
+        GattDevice device;
+        std::string path;
+        std::vector<Aggregate> aggregates;
+        std::vector<guint> subscriptions;
+        State state;
+        gint64 due;
+        unsigned failures;
+        unsigned discovery_attempts;
+        unsigned generation;
+        unsigned pending_notify;
+        unsigned notifying;
+    };
+
+    struct Subscription
+    {
+        GattStream* stream;
+        gsize entry;
+        gsize characteristic;
+    };
+
+    struct Call
+    {
+        GattStream* stream;
+        gsize entry;
+        unsigned generation;
+    };
+
+    struct NotifyCall
+    {
+        GattStream* stream;
+        gsize entry;
+        gsize characteristic;
+        unsigned generation;
+    };
+
+    static gboolean tick(gpointer user_data);
+
+    static gboolean flush(gpointer user_data);
+
+    void connect(gsize entry);
+    static void connected(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    void discover(Call* call);
+    static gboolean discover_later(gpointer user_data);
+    static void discovered(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    void subscribe(gsize entry, const std::vector<std::string>& paths);
+    static void notify_started(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    static void value_changed(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                              const gchar* interface, const gchar* signal, GVariant* parameters, gpointer user_data);
+    static void device_changed(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                               const gchar* interface, const gchar* signal, GVariant* parameters, gpointer user_data);
+    static void free_subscription(gpointer user_data);
+
+    void drop(gsize entry);
+
+    Wolk& wolk;
+    ReadingOutlet& outlet;
+    ConnectionPool& pool;
+    std::string adapter_path;
+    unsigned flush_interval;
+
+    std::vector<Entry> entries;
+};
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,56 @@
+#include "GroupOccupancy.h"
+
+namespace wolkabout
+{
+void GroupOccupancy::set_groups(gsize devices, const std::vector<std::vector<guint32>>& members)
+{
+    device_groups.assign(devices, {});
+    counts.assign(members.size(), 0);
+    is_changed.assign(members.size(), false);
+    changed.clear();
+
+    for (gsize group = 0; group < members.size(); ++group)
+    {
+        for (guint32 device : members[group])
+        {
+            if (device < devices)
+                device_groups[device].push_back(group);
+        }
+        touch(group);
+    }
+}
+
+void GroupOccupancy::transition(guint32 device, bool present)
+{
+    if (device >= device_groups.size())
+        return;
+
+    for (gsize group : device_groups[device])
+    {
+        if (present)
+            ++counts[group];
+        else if (counts[group] > 0)
+            --counts[group];
+        touch(group);
+    }
+}
+
+std::vector<gsize> GroupOccupancy::collect_changed()
+{
+    std::vector<gsize> collected;
+    collected.swap(changed);
+    for (gsize group : collected)
+        is_changed[group] = false;
+    return collected;
+}
+
+void GroupOccupancy::touch(gsize group)
+{
+    if (!is_changed[group])
+    {
+        is_changed[group] = true;
+        changed.push_back(group);
+    }
+}
+
+}    // namespace wolkabout
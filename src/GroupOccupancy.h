@@ -0,0 +1,56 @@
+#ifndef GROUPOCCUPANCY_H
+#define GROUPOCCUPANCY_H
+
+#include <glib.h>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Devices whose presence is counted together and published as the device
+ * `key`. `members` are keys of configured devices, a device may belong to
+ * several groups.
+ */
+struct DeviceGroup
+{
+    std::string name;
+    std::string key;
+    std::vector<std::string> members;
+};
+
+/**
+ * Number of present members per group, updated on each presence transition
+ * of a member rather than recounted on every snapshot.
+ */
+class GroupOccupancy
+{
+public:
+    /**
+     * `members` holds the positions of each group's devices among the
+     * `devices` configured devices, all of which start absent. Every group is
+     * reported as changed until the first collection.
+     */
+    void set_groups(gsize devices, const std::vector<std::vector<guint32>>& members);
+
+    void transition(guint32 device, bool present);
+
+    guint32 count(gsize group) const { return counts[group]; }
+
+    /**
+     * Groups whose count changed since the last call.
+     */
+    std::vector<gsize> collect_changed();
+
+private:
+    void touch(gsize group);
+
+    std::vector<std::vector<gsize>> device_groups;
+    std::vector<guint32> counts;
+
+    std::vector<bool> is_changed;
+    std::vector<gsize> changed;
+};
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,127 @@
+#include "HistoryService.h"
+#include "Bus.h"
+#include "core/utilities/Logger.h"
+
+namespace wolkabout
+{
+namespace
+{
+const char* const SERVICE_NAME = "org.wolkabout.BluetoothModule";
+const char* const SERVICE_PATH = "/org/wolkabout/bluetooth";
+const char* const SERVICE_INTERFACE = "org.wolkabout.PresenceHistory1";
+
+const char* const INTROSPECTION = "<node>"
+                                  "  <interface name='org.wolkabout.PresenceHistory1'>"
+                                  "    <method name='Query'>"
+                                  "      <arg name='key' type='s' direction='in'/>"
+                                  "      <arg name='from' type='t' direction='in'/>"
+                                  "      <arg name='to' type='t' direction='in'/>"
+                                  "      <arg name='ratio' type='d' direction='out'/>"
+                                  "      <arg name='first_seen' type='t' direction='out'/>"
+                                  "      <arg name='last_seen' type='t' direction='out'/>"
+                                  "    </method>"
+                                  "    <method name='QueryAll'>"
+                                  "      <arg name='from' type='t' direction='in'/>"
+                                  "      <arg name='to' type='t' direction='in'/>"
+                                  "      <arg name='devices' type='a{s(dtt)}' direction='out'/>"
+                                  "    </method>"
+                                  "  </interface>"
+                                  "</node>";
+}    // namespace
+
+HistoryService::HistoryService(const PresenceHistory& presence_history, const std::vector<std::string>& keys,
+                               const ShardSettings& shard)
+: history(presence_history)
+, device_keys(keys)
+, service_name(shard.count > 1 ? std::string(SERVICE_NAME) + ".Shard" + std::to_string(shard.index) : SERVICE_NAME)
+, registration(0)
+, name(0)
+{
+    for (gsize i = 0; i < device_keys.size(); ++i)
+        devices.emplace(device_keys[i], static_cast<guint32>(i));
+}
+
+HistoryService::~HistoryService()
+{
+    if (name != 0)
+        g_bus_unown_name(name);
+    if (registration != 0)
+        g_dbus_connection_unregister_object(Bus::connection(), registration);
+}
+
+bool HistoryService::start()
+{
+    static GDBusNodeInfo* info = g_dbus_node_info_new_for_xml(INTROSPECTION, NULL);
+    static const GDBusInterfaceVTable vtable = {HistoryService::method_call, NULL, NULL, {0}};
+
+    GError* error = NULL;
+    registration = g_dbus_connection_register_object(Bus::connection(), SERVICE_PATH,
+                                                     g_dbus_node_info_lookup_interface(info, SERVICE_INTERFACE),
+                                                     &vtable, this, NULL, &error);
+    if (error != NULL)
+    {
+        LOG(ERROR) << "Unable to export the presence history: " << error->message;
+        g_error_free(error);
+        registration = 0;
+        return false;
+    }
+
+    name = g_bus_own_name_on_connection(Bus::connection(), service_name.c_str(), G_BUS_NAME_OWNER_FLAGS_NONE, NULL,
+                                        HistoryService::name_lost, this, NULL);
+    return true;
+}
+
+void HistoryService::name_lost(GDBusConnection* connection, const gchar* lost_name, gpointer user_data)
+{
+    (void)connection;
+    (void)user_data;
+
+    LOG(WARN) << "Unable to own " << lost_name << ", the presence history is only reachable at the unique bus name";
+}
+
+void HistoryService::method_call(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                                 const gchar* interface, const gchar* method, GVariant* parameters,
+                                 GDBusMethodInvocation* invocation, gpointer user_data)
+{
+    (void)connection;
+    (void)sender;
+    (void)object_path;
+    (void)interface;
+
+    const HistoryService* service = static_cast<const HistoryService*>(user_data);
+    guint64 from;
+    guint64 to;
+
+    if (!g_strcmp0(method, "Query"))
+    {
+        const gchar* key;
+        g_variant_get(parameters, "(&stt)", &key, &from, &to);
+
+        const auto device = service->devices.find(key);
+        if (device == service->devices.end())
+        {
+            g_dbus_method_invocation_return_dbus_error(invocation, "org.wolkabout.PresenceHistory1.Error.UnknownDevice",
+                                                       key);
+            return;
+        }
+
+        const HistorySummary summary = service->history.query(device->second, from, to);
+        g_dbus_method_invocation_return_value(
+          invocation, g_variant_new("(dtt)", summary.ratio, summary.first_seen, summary.last_seen));
+        return;
+    }
+
+    g_variant_get(parameters, "(tt)", &from, &to);
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{s(dtt)}"));
+    for (gsize i = 0; i < service->device_keys.size(); ++i)
+    {
+        const HistorySummary summary = service->history.query(static_cast<guint32>(i), from, to);
+        g_variant_builder_add(&builder, "{s(dtt)}", service->device_keys[i].c_str(), summary.ratio,
+                              summary.first_seen, summary.last_seen);
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{s(dtt)})", &builder));
+}
+
+}    // namespace wolkabout
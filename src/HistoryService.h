@@ -0,0 +1,59 @@
+#ifndef HISTORYSERVICE_H
+#define HISTORYSERVICE_H
+
+#include "PresenceHistory.h"
+#include "Shard.h"
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Answers presence history queries of local dashboards over D-Bus, as
+ * org.wolkabout.PresenceHistory1 on /org/wolkabout/bluetooth under the name
+ * org.wolkabout.BluetoothModule:
+ *
+ *   Query(s key, t from, t to) -> (d ratio, t first_seen, t last_seen)
+ *   QueryAll(t from, t to) -> a{s(dtt)}
+ *
+ * Times are Unix seconds and `to` is excluded. Calls are served on the main
+ * loop. With more than one shard every instance owns the name with
+ * ".Shard<index>" appended.
+ */
+class HistoryService
+{
+public:
+    /**
+     * `keys` are the device keys in the order of the history's devices.
+     */
+    HistoryService(const PresenceHistory& history, const std::vector<std::string>& keys, const ShardSettings& shard);
+
+    ~HistoryService();
+
+    HistoryService(const HistoryService&) = delete;
+    HistoryService& operator=(const HistoryService&) = delete;
+
+    bool start();
+
+private:
+    static void method_call(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                            const gchar* interface, const gchar* method, GVariant* parameters,
+                            GDBusMethodInvocation* invocation, gpointer user_data);
+
+    static void name_lost(GDBusConnection* connection, const gchar* name, gpointer user_data);
+
+    const PresenceHistory& history;
+    std::vector<std::string> device_keys;
+    std::unordered_map<std::string, guint32> devices;
+    std::string service_name;
+
+    guint registration;
+    guint name;
+};
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,130 @@
+#include "IrkResolver.h"
+#include "Aes128.h"
+#include "utils.h"
+
+namespace wolkabout
+{
+bool parse_irk(const std::string& hex, IdentityResolvingKey& irk)
+{
+    if (hex.size() != 32)
+        return false;
+
+    for (gsize i = 0; i < 16; ++i)
+    {
+        const int high = g_ascii_xdigit_value(hex[2 * i]);
+        const int low = g_ascii_xdigit_value(hex[2 * i + 1]);
+        if (high < 0 || low < 0)
+            return false;
+        irk.bytes[i] = static_cast<guint8>((high << 4) | low);
+    }
+    return true;
+}
+
+IrkResolver::IrkResolver(gsize max_entries, gint64 lifetime) : cache_size(max_entries), cache_lifetime(lifetime)
+{
+}
+
+void IrkResolver::add(const IdentityResolvingKey& irk, const std::string& key)
+{
+    round_keys.resize(round_keys.size() + AES128_ROUND_KEYS_SIZE);
+    aes128_expand_key(irk.bytes, &round_keys[round_keys.size() - AES128_ROUND_KEYS_SIZE]);
+    keys.push_back(key);
+    cache.clear();
+    cache_order.clear();
+}
+
+bool IrkResolver::empty() const
+{
+    return keys.empty();
+}
+
+bool IrkResolver::is_resolvable(const std::string& address)
+{
+    // The two most significant bits of a resolvable private address are 0b01
+    if (address.size() != 17)
+        return false;
+
+    const int digit = g_ascii_xdigit_value(address[0]);
+    return digit >= 0 && (digit & 0xC) == 0x4;
+}
+
+const std::string* IrkResolver::resolve(const std::string& address)
+{
+    guint64 value;
+    if (keys.empty() || !parse_address(address, value))
+        return nullptr;
+
+    const gint64 now = g_get_monotonic_time();
+    int device;
+    if (lookup(value, now, device))
+        return device < 0 ? nullptr : &keys[static_cast<gsize>(device)];
+
+    // Trials of different adapter threads run in parallel, only the cache is shared
+    device = trial(value);
+
+    std::lock_guard<std::mutex> lock(cache_lock);
+    auto cached = cache.find(value);
+    if (cached != cache.end())
+    {
+        cached->second = CacheEntry{now + cache_lifetime, device};
+    }
+    else
+    {
+        if (cache.size() >= cache_size)
+        {
+            cache.erase(cache_order.front());
+            cache_order.pop_front();
+        }
+        cache.emplace(value, CacheEntry{now + cache_lifetime, device});
+        cache_order.push_back(value);
+    }
+
+    return device < 0 ? nullptr : &keys[static_cast<gsize>(device)];
+}
+
+const std::string* IrkResolver::cached(const std::string& address)
+{
+    guint64 value;
+    int device;
+    if (keys.empty() || !parse_address(address, value) || !lookup(value, g_get_monotonic_time(), device) ||
+        device < 0)
+        return nullptr;
+
+    return &keys[static_cast<gsize>(device)];
+}
+
+bool IrkResolver::lookup(guint64 address, gint64 now, int& device)
+{
+    std::lock_guard<std::mutex> lock(cache_lock);
+    auto entry = cache.find(address);
+    if (entry == cache.end() || entry->second.expires <= now)
+        return false;
+
+    device = entry->second.device;
+    return true;
+}
+
+int IrkResolver::trial(guint64 address)
+{
+    // ah(k, r) = e(k, padding || prand) mod 2^24, compared against the hash in the low 24 bits
+    guint8 plaintext[AES128_BLOCK_SIZE] = {};
+    plaintext[13] = static_cast<guint8>(address >> 40);
+    plaintext[14] = static_cast<guint8>(address >> 32);
+    plaintext[15] = static_cast<guint8>(address >> 24);
+
+    const guint8 hash[3] = {static_cast<guint8>(address >> 16), static_cast<guint8>(address >> 8),
+                            static_cast<guint8>(address)};
+
+    std::vector<guint8> ciphertexts(keys.size() * AES128_BLOCK_SIZE);
+    aes128_encrypt_batch(round_keys.data(), keys.size(), plaintext, ciphertexts.data());
+
+    for (gsize i = 0; i < keys.size(); ++i)
+    {
+        const guint8* ciphertext = &ciphertexts[i * AES128_BLOCK_SIZE];
+        if (ciphertext[13] == hash[0] && ciphertext[14] == hash[1] && ciphertext[15] == hash[2])
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+}    // namespace wolkabout
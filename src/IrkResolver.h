@@ -0,0 +1,72 @@
+#ifndef IRKRESOLVER_H
+#define IRKRESOLVER_H
+
+#include <glib.h>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+struct IdentityResolvingKey
+{
+    guint8 bytes[16];
+};
+
+/**
+ * Parses 32 hexadecimal digits, most significant octet first.
+ */
+bool parse_irk(const std::string& hex, IdentityResolvingKey& irk);
+
+/**
+ * Resolves Resolvable Private Addresses to the devices owning them.
+ * A new address is tried against all IRKs in one batch, after which the
+ * outcome, positive or negative, is cached so each address rotation costs a
+ * single trial. `resolve` is safe to call from several threads once all keys
+ * are added.
+ */
+class IrkResolver
+{
+public:
+    IrkResolver(gsize max_entries = 4096, gint64 lifetime = 30 * 60 * G_USEC_PER_SEC);
+
+    void add(const IdentityResolvingKey& irk, const std::string& key);
+
+    bool empty() const;
+
+    static bool is_resolvable(const std::string& address);
+
+    const std::string* resolve(const std::string& address);
+
+    /**
+     * The key the address was last resolved to while that outcome is cached,
+     * without trying unresolved addresses.
+     */
+    const std::string* cached(const std::string& address);
+
+private:
+    struct CacheEntry
+    {
+        gint64 expires;
+        int device;
+    };
+
+    bool lookup(guint64 address, gint64 now, int& device);
+
+    int trial(guint64 address);
+
+    gsize cache_size;
+    gint64 cache_lifetime;
+
+    std::vector<guint8> round_keys;
+    std::vector<std::string> keys;
+
+    std::mutex cache_lock;
+    std::unordered_map<guint64, CacheEntry> cache;
+    std::deque<guint64> cache_order;
+};
+
+}    // namespace wolkabout
+#endif
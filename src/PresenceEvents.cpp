@@ -0,0 +1,33 @@
+#include "PresenceEvents.h"
+
+namespace wolkabout
+{
+const EventSettings PresenceEvents::DEFAULT_SETTINGS = {false, 1000, 10, 20};
+
+bool valid_event_settings(const EventSettings& settings)
+{
+    return settings.rate > 0 && settings.burst >= 1;
+}
+
+PresenceEvents::PresenceEvents(const EventSettings& event_settings)
+: settings(event_settings), bucket(event_settings.rate, event_settings.burst)
+{
+}
+
+bool PresenceEvents::allow(const std::string& key, gint64 now)
+{
+    if (!settings.enabled)
+        return false;
+
+    const auto last = published.find(key);
+    if (last != published.end() && now - last->second < static_cast<gint64>(settings.spacing) * 1000)
+        return false;
+
+    if (!bucket.take(now))
+        return false;
+
+    published[key] = now;
+    return true;
+}
+
+}    // namespace wolkabout
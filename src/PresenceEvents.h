@@ -0,0 +1,51 @@
+#ifndef PRESENCEEVENTS_H
+#define PRESENCEEVENTS_H
+
+#include "TokenBucket.h"
+
+#include <glib.h>
+#include <string>
+#include <unordered_map>
+
+namespace wolkabout
+{
+/**
+ * Presence transitions are published as they happen when `enabled`. Events of
+ * one device are at least `spacing` milliseconds apart and all devices
+ * together publish at most `rate` events per second with bursts of `burst`.
+ */
+struct EventSettings
+{
+    bool enabled;
+    unsigned spacing;
+    double rate;
+    double burst;
+};
+
+bool valid_event_settings(const EventSettings& settings);
+
+/**
+ * Decides which presence transitions are published immediately. A transition
+ * that is refused is not queued, the periodic presence snapshot carries it.
+ */
+class PresenceEvents
+{
+public:
+    static const EventSettings DEFAULT_SETTINGS;
+
+    explicit PresenceEvents(const EventSettings& event_settings = DEFAULT_SETTINGS);
+
+    bool enabled() const { return settings.enabled; }
+
+    bool allow(const std::string& key, gint64 now = g_get_monotonic_time());
+
+private:
+    EventSettings settings;
+    TokenBucket bucket;
+
+    // Time of the last published event per device
+    std::unordered_map<std::string, gint64> published;
+};
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,204 @@
+#include "PresenceHistory.h"
+#include "core/utilities/Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wolkabout
+{
+namespace
+{
+const guint32 HISTORY_MAGIC = 0x31485057;    // "WPH1"
+const guint64 SECONDS_PER_DAY = 86400;
+}    // namespace
+
+const HistorySettings PresenceHistory::DEFAULT_SETTINGS = {60, 7};
+
+bool valid_history_settings(const HistorySettings& settings)
+{
+    return settings.resolution > 0 && settings.retention_days > 0;
+}
+
+PresenceHistory::PresenceHistory() : header(nullptr), words(nullptr), mapped(0)
+{
+    static_assert(sizeof(Header) == 32, "The history header must stay 32 bytes");
+}
+
+PresenceHistory::~PresenceHistory()
+{
+    close();
+}
+
+bool PresenceHistory::open(const std::string& path, guint32 devices, guint32 fingerprint,
+                           const HistorySettings& settings)
+{
+    close();
+
+    // Whole words per device, so no word straddles the end of a ring
+    const guint64 retention = settings.retention_days * SECONDS_PER_DAY;
+    const guint64 intervals = (retention + settings.resolution - 1) / settings.resolution;
+    const guint64 slots = (intervals + 63) / 64 * 64;
+    const gsize size = sizeof(Header) + devices * slots / 8;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        LOG(ERROR) << "Unable to open presence history " << path << ": " << g_strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    const bool reuse = fstat(fd, &st) == 0 && static_cast<gsize>(st.st_size) == size;
+
+    if (!reuse && (ftruncate(fd, 0) != 0 || posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0))
+    {
+        LOG(ERROR) << "Unable to reserve " << size << " bytes for presence history " << path;
+        ::close(fd);
+        return false;
+    }
+
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        LOG(ERROR) << "Unable to map presence history " << path << ": " << g_strerror(errno);
+        return false;
+    }
+
+    mapped = size;
+    header = static_cast<Header*>(memory);
+    words = reinterpret_cast<guint64*>(header + 1);
+
+    if (!reuse || header->magic != HISTORY_MAGIC || header->fingerprint != fingerprint ||
+        header->devices != devices || header->resolution != settings.resolution || header->slots != slots)
+    {
+        if (reuse && header->magic == HISTORY_MAGIC && header->newest != 0)
+        {
+            LOG(WARN) << "Discarding the presence history, the configured devices or history settings have changed";
+        }
+
+        memset(words, 0, size - sizeof(Header));
+        header->magic = HISTORY_MAGIC;
+        header->fingerprint = fingerprint;
+        header->devices = devices;
+        header->resolution = settings.resolution;
+        header->slots = slots;
+        header->newest = 0;
+    }
+
+    return true;
+}
+
+void PresenceHistory::close()
+{
+    if (header == nullptr)
+        return;
+
+    msync(header, mapped, MS_SYNC);
+    munmap(header, mapped);
+    header = nullptr;
+    words = nullptr;
+    mapped = 0;
+}
+
+void PresenceHistory::advance(guint64 now)
+{
+    const guint64 slot = now / header->resolution;
+    if (header->newest == 0)
+    {
+        header->newest = slot;
+        return;
+    }
+    if (slot <= header->newest)
+        return;
+
+    if (slot - header->newest >= header->slots)
+    {
+        memset(words, 0, mapped - sizeof(Header));
+    }
+    else
+    {
+        for (guint64 cleared = header->newest + 1; cleared <= slot; ++cleared)
+        {
+            const guint64 position = cleared % header->slots;
+            const guint64 mask = ~(static_cast<guint64>(1) << (position % 64));
+            for (guint32 device = 0; device < header->devices; ++device)
+                row(device)[position / 64] &= mask;
+        }
+    }
+    header->newest = slot;
+}
+
+void PresenceHistory::mark(guint32 device, guint64 from, guint64 to)
+{
+    if (device >= header->devices || from > to)
+        return;
+
+    advance(to);
+
+    const guint64 oldest = header->newest + 1 > header->slots ? header->newest + 1 - header->slots : 0;
+    guint64* bits = row(device);
+    for (guint64 slot = std::max(from / header->resolution, oldest); slot <= to / header->resolution; ++slot)
+    {
+        const guint64 position = slot % header->slots;
+        bits[position / 64] |= static_cast<guint64>(1) << (position % 64);
+    }
+}
+
+HistorySummary PresenceHistory::query(guint32 device, guint64 from, guint64 to) const
+{
+    HistorySummary summary = {0, 0, 0};
+    if (header == nullptr || device >= header->devices || header->newest == 0)
+        return summary;
+
+    const guint64 resolution = header->resolution;
+    const guint64 oldest = header->newest + 1 > header->slots ? header->newest + 1 - header->slots : 0;
+    const guint64 begin = std::max(from / resolution, oldest);
+    const guint64 end = std::min((to + resolution - 1) / resolution, header->newest + 1);
+    if (begin >= end)
+        return summary;
+
+    const guint64* bits = row(device);
+    guint64 present = 0;
+    guint64 first = 0;
+    guint64 last = 0;
+    for (guint64 slot = begin; slot < end;)
+    {
+        const guint64 offset = slot % 64;
+        const guint64 count = std::min(64 - offset, end - slot);
+        const guint64 mask = (count == 64 ? ~static_cast<guint64>(0) : (static_cast<guint64>(1) << count) - 1)
+                             << offset;
+        const guint64 set = bits[(slot % header->slots) / 64] & mask;
+        if (set != 0)
+        {
+            // Slot of the word's lowest bit
+            const guint64 base = slot - offset;
+            if (present == 0)
+                first = base + static_cast<guint64>(__builtin_ctzll(set));
+            last = base + 63 - static_cast<guint64>(__builtin_clzll(set));
+            present += static_cast<guint64>(__builtin_popcountll(set));
+        }
+        slot += count;
+    }
+
+    if (present != 0)
+    {
+        summary.ratio = static_cast<double>(present) / static_cast<double>(end - begin);
+        summary.first_seen = first * resolution;
+        summary.last_seen = (last + 1) * resolution;
+    }
+    return summary;
+}
+
+void PresenceHistory::sync()
+{
+    if (header != nullptr)
+        msync(header, mapped, MS_ASYNC);
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,100 @@
+#ifndef PRESENCEHISTORY_H
+#define PRESENCEHISTORY_H
+
+#include <glib.h>
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * Presence is kept in intervals of `resolution` seconds for
+ * `retention_days` days.
+ */
+struct HistorySettings
+{
+    unsigned resolution;
+    unsigned retention_days;
+};
+
+bool valid_history_settings(const HistorySettings& settings);
+
+/**
+ * Presence of one device over a range. `ratio` is the share of the retained
+ * intervals in the range the device was present in, `first_seen` the start
+ * of the first of them and `last_seen` the end of the last, in Unix seconds
+ * and zero when it was not present at all.
+ */
+struct HistorySummary
+{
+    double ratio;
+    guint64 first_seen;
+    guint64 last_seen;
+};
+
+/**
+ * Presence history of the configured devices in a memory-mapped file, one bit
+ * per device and interval. Each device has a ring of 64 bit words covering the
+ * retention period, rounded up to whole words, and the oldest interval is
+ * cleared when a new one starts. A bit is set when the device was present at
+ * any time in the interval. Ranges are summarised a word at a time with
+ * popcount. The history survives restarts as long as the configured devices,
+ * identified by `fingerprint`, and the settings are unchanged.
+ */
+class PresenceHistory
+{
+public:
+    static const HistorySettings DEFAULT_SETTINGS;
+
+    PresenceHistory();
+
+    ~PresenceHistory();
+
+    PresenceHistory(const PresenceHistory&) = delete;
+    PresenceHistory& operator=(const PresenceHistory&) = delete;
+
+    bool open(const std::string& path, guint32 devices, guint32 fingerprint, const HistorySettings& settings);
+
+    bool is_open() const { return header != nullptr; }
+
+    /**
+     * Starts the intervals up to `now`, clearing the ones they replace.
+     */
+    void advance(guint64 now);
+
+    /**
+     * Marks the device present from `from` to `to`, both in Unix seconds.
+     */
+    void mark(guint32 device, guint64 from, guint64 to);
+
+    /**
+     * Summarises the device's presence from `from` up to but excluding `to`.
+     */
+    HistorySummary query(guint32 device, guint64 from, guint64 to) const;
+
+    /**
+     * Schedules the written pages to be flushed to disk.
+     */
+    void sync();
+
+private:
+    struct Header
+    {
+        guint32 magic;
+        guint32 fingerprint;
+        guint32 devices;
+        guint32 resolution;
+        guint64 slots;
+        guint64 newest;
+    };
+
+    void close();
+
+    guint64* row(guint32 device) const { return words + device * (header->slots / 64); }
+
+    Header* header;
+    guint64* words;
+    gsize mapped;
+};
+
+}    // namespace wolkabout
+#endif
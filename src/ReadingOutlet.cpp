@@ -0,0 +1,177 @@
+#include "ReadingOutlet.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wolkabout
+{
+ReadingOutlet::ReadingOutlet() : wolk(nullptr), is_offline(false), holding(0), handed(0) {}
+
+void ReadingOutlet::set_wolk(Wolk& wolk_instance)
+{
+    wolk = &wolk_instance;
+}
+
+void ReadingOutlet::set_keys(const std::vector<std::string>& device_keys)
+{
+    keys = device_keys;
+    index.clear();
+    for (gsize i = 0; i < keys.size(); ++i)
+        index.emplace(keys[i], static_cast<guint32>(i));
+}
+
+bool ReadingOutlet::open_store(const std::string& path, gsize budget)
+{
+    guint32 fingerprint = 5381;
+    for (const auto& key : keys)
+        fingerprint = (fingerprint * 33) ^ g_str_hash(key.c_str());
+
+    std::lock_guard<std::mutex> guard(lock);
+    handed = 0;
+    return store.open(path, budget, fingerprint);
+}
+
+void ReadingOutlet::set_offline(bool offline)
+{
+    is_offline = offline;
+}
+
+bool ReadingOutlet::offline() const
+{
+    return is_offline && store.is_open();
+}
+
+void ReadingOutlet::hold(const std::string& key)
+{
+    std::lock_guard<std::mutex> guard(held_lock);
+    if (held.emplace(key, std::vector<HeldReading>()).second)
+        ++holding;
+}
+
+void ReadingOutlet::release(const std::string& key)
+{
+    std::vector<HeldReading> readings;
+    {
+        std::lock_guard<std::mutex> guard(held_lock);
+        const auto device = held.find(key);
+        if (device == held.end())
+            return;
+
+        readings.swap(device->second);
+        held.erase(device);
+        --holding;
+    }
+
+    for (const auto& reading : readings)
+        route(key, reading.reference, reading.value, reading.integral, reading.rtc);
+}
+
+bool ReadingOutlet::hold_back(const std::string& key, const std::string& reference, double value, bool integral,
+                              guint64 rtc)
+{
+    std::lock_guard<std::mutex> guard(held_lock);
+    const auto device = held.find(key);
+    if (device == held.end())
+        return false;
+
+    // Held readings are stamped now, they may be handed much later
+    if (rtc == 0)
+        rtc = static_cast<guint64>(g_get_real_time() / 1000);
+
+    auto& readings = device->second;
+    if (readings.size() == HOLD_LIMIT)
+        readings.erase(readings.begin());
+    readings.push_back(HeldReading{reference, value, integral, rtc});
+    return true;
+}
+
+void ReadingOutlet::route(const std::string& key, const std::string& reference, double value, bool integral,
+                          guint64 rtc)
+{
+    if (holding > 0 && hold_back(key, reference, value, integral, rtc))
+        return;
+
+    if (offline())
+    {
+        const auto device = index.find(key);
+        if (device != index.end())
+        {
+            if (rtc == 0)
+                rtc = static_cast<guint64>(g_get_real_time() / 1000);
+
+            std::lock_guard<std::mutex> guard(lock);
+            const gsize size = store.size();
+            store.append(device->second, reference, value, integral, rtc);
+
+            // A full store overwrote its oldest reading, which may have been handed already
+            if (store.size() == size && handed > 0)
+                --handed;
+            return;
+        }
+    }
+
+    hand(key, reference, value, integral, rtc);
+}
+
+void ReadingOutlet::hand(const std::string& key, const std::string& reference, double value, bool integral,
+                         guint64 rtc)
+{
+    if (integral)
+        wolk->addSensorReading(key, reference, static_cast<long long>(value), rtc);
+    else
+        wolk->addSensorReading(key, reference, value, rtc);
+}
+
+gsize ReadingOutlet::stored()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return store.size();
+}
+
+gsize ReadingOutlet::replay(gsize count)
+{
+    std::vector<StoredReading> readings;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (; readings.size() < count && handed < store.size(); ++handed)
+            readings.push_back(store.at(handed));
+    }
+
+    for (const auto& reading : readings)
+    {
+        if (reading.device < keys.size())
+        {
+            const std::string reference(reading.reference, strnlen(reading.reference, sizeof(reading.reference)));
+            hand(keys[reading.device], reference, reading.value, reading.integral != 0, reading.rtc);
+        }
+    }
+    return readings.size();
+}
+
+void ReadingOutlet::confirm(gsize count)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    count = std::min(count, handed);
+    store.pop(count);
+    handed -= count;
+}
+
+void ReadingOutlet::rewind()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    handed = 0;
+}
+
+void ReadingOutlet::sync()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    store.sync();
+}
+
+guint64 ReadingOutlet::collect_evicted()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return store.collect_evicted();
+}
+
+}    // namespace wolkabout
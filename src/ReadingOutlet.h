@@ -0,0 +1,142 @@
+#ifndef READINGOUTLET_H
+#define READINGOUTLET_H
+
+#include "ReadingRing.h"
+#include "Wolk.h"
+
+#include <atomic>
+#include <glib.h>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Path of every sensor reading to Wolk. While the gateway is unreachable,
+ * readings of the known keys are appended to the offline store instead of
+ * piling up in Wolk's memory. Stored readings are handed back to Wolk in
+ * batches and stay in the store until their delivery is confirmed, so a
+ * publish that fails during replay is repeated instead of lost. Readings of
+ * devices not yet added to Wolk are held until they are. Safe to use from the
+ * adapter threads.
+ */
+class ReadingOutlet
+{
+public:
+    ReadingOutlet();
+
+    ReadingOutlet(const ReadingOutlet&) = delete;
+    ReadingOutlet& operator=(const ReadingOutlet&) = delete;
+
+    /**
+     * Must be called before readings arrive.
+     */
+    void set_wolk(Wolk& wolk);
+
+    /**
+     * Keys whose readings can be stored, in the order the store records
+     * them. Must be called before the store is opened.
+     */
+    void set_keys(const std::vector<std::string>& keys);
+
+    /**
+     * Stored readings are discarded when the keys changed since they were
+     * written.
+     */
+    bool open_store(const std::string& path, gsize budget);
+
+    bool has_store() const { return store.is_open(); }
+
+    /**
+     * Readings go to the store while offline, if one is open.
+     */
+    void set_offline(bool offline);
+
+    bool offline() const;
+
+    /**
+     * Holds the key's readings, up to HOLD_LIMIT of the latest, until it is
+     * released. Must be called before readings arrive.
+     */
+    void hold(const std::string& key);
+
+    /**
+     * Routes the held readings of the key and stops holding it, once the
+     * device was added to Wolk.
+     */
+    void release(const std::string& key);
+
+    /**
+     * `rtc` is in milliseconds, zero meaning now.
+     */
+    template <typename T> void add(const std::string& key, const std::string& reference, T value, guint64 rtc = 0)
+    {
+        route(key, reference, static_cast<double>(value), std::is_integral<T>::value, rtc);
+    }
+
+    gsize stored();
+
+    /**
+     * Hands up to `count` stored readings following the ones handed before
+     * to Wolk and returns how many were handed.
+     */
+    gsize replay(gsize count);
+
+    /**
+     * The `count` oldest handed readings were delivered and leave the store.
+     */
+    void confirm(gsize count);
+
+    /**
+     * Handed readings that were not confirmed are handed again.
+     */
+    void rewind();
+
+    /**
+     * Schedules the stored readings to be flushed to disk.
+     */
+    void sync();
+
+    /**
+     * Readings overwritten before they could be replayed since the last call.
+     */
+    guint64 collect_evicted();
+
+private:
+    static const gsize HOLD_LIMIT = 16;
+
+    struct HeldReading
+    {
+        std::string reference;
+        double value;
+        bool integral;
+        guint64 rtc;
+    };
+
+    bool hold_back(const std::string& key, const std::string& reference, double value, bool integral, guint64 rtc);
+
+    void route(const std::string& key, const std::string& reference, double value, bool integral, guint64 rtc);
+
+    void hand(const std::string& key, const std::string& reference, double value, bool integral, guint64 rtc);
+
+    Wolk* wolk;
+    std::vector<std::string> keys;
+    std::unordered_map<std::string, guint32> index;
+    std::atomic<bool> is_offline;
+
+    // Guards the held readings, `holding` counts the held keys so others skip the lock
+    std::mutex held_lock;
+    std::unordered_map<std::string, std::vector<HeldReading>> held;
+    std::atomic<gsize> holding;
+
+    // Guards the store and the number of readings handed from it
+    std::mutex lock;
+    ReadingRing store;
+    gsize handed;
+};
+
+}    // namespace wolkabout
+#endif
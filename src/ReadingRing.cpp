@@ -0,0 +1,162 @@
+#include "ReadingRing.h"
+#include "core/utilities/Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wolkabout
+{
+namespace
+{
+const guint32 RING_MAGIC = 0x31525257;    // "WRR1"
+}
+
+ReadingRing::ReadingRing() : header(nullptr), records(nullptr), mapped(0), evicted(0)
+{
+    static_assert(sizeof(StoredReading) == 32, "Stored readings must stay 32 bytes");
+    static_assert(sizeof(Header) == 32, "The ring header must stay 32 bytes");
+}
+
+ReadingRing::~ReadingRing()
+{
+    close();
+}
+
+bool ReadingRing::open(const std::string& path, gsize budget, guint32 fingerprint)
+{
+    close();
+
+    if (budget < sizeof(Header) + sizeof(StoredReading))
+    {
+        LOG(ERROR) << "Offline store budget of " << budget << " bytes is too small";
+        return false;
+    }
+
+    const guint64 capacity = (budget - sizeof(Header)) / sizeof(StoredReading);
+    const gsize size = sizeof(Header) + capacity * sizeof(StoredReading);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        LOG(ERROR) << "Unable to open offline store " << path << ": " << g_strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    const bool reuse = fstat(fd, &st) == 0 && static_cast<gsize>(st.st_size) == size;
+
+    // Reserve the whole budget up front so writing through the mapping cannot fail on a full disk
+    if (!reuse && (ftruncate(fd, 0) != 0 || posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0))
+    {
+        LOG(ERROR) << "Unable to reserve " << size << " bytes for offline store " << path;
+        ::close(fd);
+        return false;
+    }
+
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        LOG(ERROR) << "Unable to map offline store " << path << ": " << g_strerror(errno);
+        return false;
+    }
+
+    mapped = size;
+    header = static_cast<Header*>(memory);
+    records = reinterpret_cast<StoredReading*>(header + 1);
+
+    if (!reuse || header->magic != RING_MAGIC || header->fingerprint != fingerprint ||
+        header->capacity != capacity || header->tail - header->head > capacity)
+    {
+        if (reuse && header->magic == RING_MAGIC && header->tail != header->head)
+        {
+            LOG(WARN) << "Discarding " << header->tail - header->head
+                      << " stored readings, the configured devices have changed";
+        }
+
+        header->magic = RING_MAGIC;
+        header->fingerprint = fingerprint;
+        header->capacity = capacity;
+        header->head = 0;
+        header->tail = 0;
+    }
+    else if (header->tail != header->head)
+    {
+        LOG(INFO) << "Offline store holds " << header->tail - header->head << " readings";
+    }
+
+    return true;
+}
+
+void ReadingRing::close()
+{
+    if (header == nullptr)
+        return;
+
+    msync(header, mapped, MS_SYNC);
+    munmap(header, mapped);
+    header = nullptr;
+    records = nullptr;
+    mapped = 0;
+}
+
+void ReadingRing::append(guint32 device, const std::string& reference, double value, bool integral, guint64 rtc)
+{
+    if (header->tail - header->head == header->capacity)
+    {
+        ++header->head;
+        ++evicted;
+    }
+
+    StoredReading& record = records[header->tail % header->capacity];
+    record.rtc = rtc;
+    record.value = value;
+    record.sequence = static_cast<guint32>(header->tail);
+    record.device = device;
+    memset(record.reference, 0, sizeof(record.reference));
+    memcpy(record.reference, reference.data(), std::min(reference.size(), sizeof(record.reference)));
+    record.integral = integral ? 1 : 0;
+
+    // The record is complete before it becomes visible after a crash
+    ++header->tail;
+}
+
+gsize ReadingRing::size() const
+{
+    return header == nullptr ? 0 : static_cast<gsize>(header->tail - header->head);
+}
+
+const StoredReading& ReadingRing::front() const
+{
+    return records[header->head % header->capacity];
+}
+
+const StoredReading& ReadingRing::at(gsize position) const
+{
+    return records[(header->head + position) % header->capacity];
+}
+
+void ReadingRing::pop(gsize count)
+{
+    header->head += std::min(static_cast<guint64>(count), header->tail - header->head);
+}
+
+void ReadingRing::sync()
+{
+    if (header != nullptr)
+        msync(header, mapped, MS_ASYNC);
+}
+
+guint64 ReadingRing::collect_evicted()
+{
+    const guint64 collected = evicted;
+    evicted = 0;
+    return collected;
+}
+
+}    // namespace wolkabout
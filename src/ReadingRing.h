@@ -0,0 +1,95 @@
+#ifndef READINGRING_H
+#define READINGRING_H
+
+#include <glib.h>
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * Reading kept while the gateway is unreachable. `device` indexes the
+ * configured devices and `reference` holds up to six characters of the sensor
+ * reference, without a terminator when all six are used. Integral readings are
+ * replayed as integers.
+ */
+struct StoredReading
+{
+    guint64 rtc;
+    double value;
+    guint32 sequence;
+    guint32 device;
+    char reference[6];
+    guint16 integral;
+};
+
+/**
+ * Append-only ring of readings in a memory-mapped file. The file is a 32 byte
+ * header followed by fixed size records, so its size is the disk budget. When
+ * the ring is full the oldest reading is overwritten. Readings survive restarts
+ * as long as the set of configured devices, identified by `fingerprint`, is
+ * unchanged.
+ */
+class ReadingRing
+{
+public:
+    ReadingRing();
+
+    ~ReadingRing();
+
+    ReadingRing(const ReadingRing&) = delete;
+    ReadingRing& operator=(const ReadingRing&) = delete;
+
+    bool open(const std::string& path, gsize budget, guint32 fingerprint);
+
+    bool is_open() const { return header != nullptr; }
+
+    void append(guint32 device, const std::string& reference, double value, bool integral, guint64 rtc);
+
+    gsize size() const;
+
+    /**
+     * Oldest stored reading, the ring must not be empty.
+     */
+    const StoredReading& front() const;
+
+    /**
+     * The `position`-th oldest stored reading, `position` must be below
+     * `size()`.
+     */
+    const StoredReading& at(gsize position) const;
+
+    /**
+     * Removes the `count` oldest readings, at most all of them.
+     */
+    void pop(gsize count = 1);
+
+    /**
+     * Schedules the written pages to be flushed to disk.
+     */
+    void sync();
+
+    /**
+     * Readings overwritten before they could be replayed since the last call.
+     */
+    guint64 collect_evicted();
+
+private:
+    struct Header
+    {
+        guint32 magic;
+        guint32 fingerprint;
+        guint64 capacity;
+        guint64 head;
+        guint64 tail;
+    };
+
+    void close();
+
+    Header* header;
+    StoredReading* records;
+    gsize mapped;
+    guint64 evicted;
+};
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,71 @@
+#include "RegistrationCache.h"
+#include "core/utilities/Logger.h"
+
+#include <cstdio>
+#include <fstream>
+#include <istream>
+
+namespace wolkabout
+{
+guint64 registration_hash(const std::string& description)
+{
+    guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+    for (unsigned char c : description)
+    {
+        hash ^= c;
+        hash *= G_GUINT64_CONSTANT(1099511628211);
+    }
+    return hash;
+}
+
+void RegistrationCache::load(const std::string& path)
+{
+    file = path;
+    previous.clear();
+    current.clear();
+
+    std::ifstream in(path);
+    std::string hash;
+    std::string key;
+    while (in >> hash && std::getline(in >> std::ws, key))
+        previous[key] = g_ascii_strtoull(hash.c_str(), NULL, 16);
+}
+
+bool RegistrationCache::unchanged(const std::string& key, guint64 hash) const
+{
+    const auto it = previous.find(key);
+    return it != previous.end() && it->second == hash;
+}
+
+void RegistrationCache::store(const std::string& key, guint64 hash)
+{
+    current[key] = hash;
+}
+
+bool RegistrationCache::save() const
+{
+    const std::string temporary = file + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        for (const auto& entry : current)
+        {
+            char hash[17];
+            g_snprintf(hash, sizeof(hash), "%016" G_GINT64_MODIFIER "x", entry.second);
+            out << hash << ' ' << entry.first << '\n';
+        }
+        if (!out.flush())
+        {
+            LOG(WARN) << "Unable to write the registration cache " << temporary;
+            return false;
+        }
+    }
+
+    if (std::rename(temporary.c_str(), file.c_str()) != 0)
+    {
+        LOG(WARN) << "Unable to replace the registration cache " << file;
+        return false;
+    }
+    return true;
+}
+
+}    // namespace wolkabout
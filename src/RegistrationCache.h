@@ -0,0 +1,46 @@
+#ifndef REGISTRATIONCACHE_H
+#define REGISTRATIONCACHE_H
+
+#include <glib.h>
+#include <string>
+#include <unordered_map>
+
+namespace wolkabout
+{
+/**
+ * 64 bit FNV-1a hash of everything a device registration is built from.
+ */
+guint64 registration_hash(const std::string& description);
+
+/**
+ * Registration hash of each device as of the last start, kept in a text file
+ * of "<hash> <key>" lines. Devices whose hash is unchanged were registered
+ * with the gateway before. Only the hashes stored since loading are saved, so
+ * removed devices are forgotten.
+ */
+class RegistrationCache
+{
+public:
+    /**
+     * A missing or unreadable file leaves the cache empty.
+     */
+    void load(const std::string& path);
+
+    bool unchanged(const std::string& key, guint64 hash) const;
+
+    void store(const std::string& key, guint64 hash);
+
+    /**
+     * Replaces the file with the stored hashes, through a temporary file so a
+     * crash cannot leave it half written.
+     */
+    bool save() const;
+
+private:
+    std::string file;
+    std::unordered_map<std::string, guint64> previous;
+    std::unordered_map<std::string, guint64> current;
+};
+
+}    // namespace wolkabout
+#endif
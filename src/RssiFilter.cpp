@@ -0,0 +1,74 @@
+#include "RssiFilter.h"
+
+#include <cmath>
+
+namespace wolkabout
+{
+namespace
+{
+// Kept as a free function, GCC only trusts restrict on parameters when deciding to vectorize
+void filter_step(gsize size, const float* __restrict q, const float* __restrict r0, const float* __restrict g,
+                 const float* __restrict a, float* __restrict s, float* __restrict c, float* __restrict x,
+                 float* __restrict p, float* __restrict init, float* __restrict seen)
+{
+    for (gsize i = 0; i < size; ++i)
+    {
+        // Sample counts are whole numbers, so this is 1 for slots with samples and 0 otherwise
+        const float has = c[i] < 1.0f ? c[i] : 1.0f;
+        const float n = c[i] > 1.0f ? c[i] : 1.0f;
+        const float z = s[i] / n;
+        const float r = r0[i] / n;
+
+        const float predicted = p[i] + q[i];
+        const float kalman = predicted / (predicted + r);
+        const float gain = g[i] + a[i] * kalman;
+
+        // The first sample is taken as is, slots without samples only grow their uncertainty
+        const float k = has * (init[i] * gain + (1.0f - init[i]));
+        const float first = has * (1.0f - init[i]);
+
+        x[i] += k * (z - x[i]);
+        p[i] = first * r + (1.0f - first) * (1.0f - k) * predicted;
+        init[i] = init[i] > has ? init[i] : has;
+        seen[i] = has;
+        s[i] = 0;
+        c[i] = 0;
+    }
+}
+}    // namespace
+
+gsize RssiFilter::add_slot(float process_noise, float measurement_noise, float gain, float measured_power,
+                           float path_loss_exponent)
+{
+    process_noises.push_back(process_noise);
+    measurement_noises.push_back(measurement_noise);
+    gains.push_back(gain);
+    adaptive.push_back(gain > 0 ? 0.0f : 1.0f);
+    measured_powers.push_back(measured_power);
+    // d = 10^((P - rssi) / (10 n)) = exp((P - rssi) * ln(10) / (10 n))
+    distance_scales.push_back(static_cast<float>(std::log(10.0) / (10.0 * path_loss_exponent)));
+
+    sum.push_back(0);
+    count.push_back(0);
+    estimate.push_back(0);
+    variance.push_back(0);
+    initialized.push_back(0);
+    fresh.push_back(0);
+
+    return estimate.size() - 1;
+}
+
+float RssiFilter::distance(gsize slot) const
+{
+    return std::exp((measured_powers[slot] - estimate[slot]) * distance_scales[slot]);
+}
+
+void RssiFilter::update()
+{
+    const gsize size = estimate.size();
+
+    filter_step(size, process_noises.data(), measurement_noises.data(), gains.data(), adaptive.data(), sum.data(),
+                count.data(), estimate.data(), variance.data(), initialized.data(), fresh.data());
+}
+
+}    // namespace wolkabout
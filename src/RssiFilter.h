@@ -0,0 +1,66 @@
+#ifndef RSSIFILTER_H
+#define RSSIFILTER_H
+
+#include <glib.h>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * Smooths the RSSI of many devices at once. Filter state is kept in one array
+ * per field, indexed by slot, and `update` runs a single branch-free pass over
+ * all slots so the compiler can vectorize it. Samples are only summed as they
+ * arrive; each update folds the mean of a slot's samples into its estimate.
+ *
+ * A slot with a zero gain runs a scalar Kalman filter whose measurement noise
+ * shrinks with the number of samples in the interval. A fixed gain turns it
+ * into exponential smoothing, a gain of one disables smoothing.
+ */
+class RssiFilter
+{
+public:
+    gsize add_slot(float process_noise, float measurement_noise, float gain, float measured_power,
+                   float path_loss_exponent);
+
+    void add(gsize slot, float rssi)
+    {
+        sum[slot] += rssi;
+        count[slot] += 1;
+    }
+
+    void update();
+
+    /**
+     * True when the last update had samples for the slot.
+     */
+    bool updated(gsize slot) const { return fresh[slot] > 0; }
+
+    float rssi(gsize slot) const { return estimate[slot]; }
+
+    /**
+     * Distance in metres from the filtered RSSI by the log-distance path loss model.
+     */
+    float distance(gsize slot) const;
+
+private:
+    // Per slot configuration
+    std::vector<float> process_noises;
+    std::vector<float> measurement_noises;
+    std::vector<float> gains;
+    std::vector<float> adaptive;
+    std::vector<float> measured_powers;
+    std::vector<float> distance_scales;
+
+    // Samples of the current interval
+    std::vector<float> sum;
+    std::vector<float> count;
+
+    // Filter state, flags are 0 or 1 so they can be used as masks
+    std::vector<float> estimate;
+    std::vector<float> variance;
+    std::vector<float> initialized;
+    std::vector<float> fresh;
+};
+
+}    // namespace wolkabout
+#endif
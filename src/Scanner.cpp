@@ -1,8 +1,29 @@
 #include "Scanner.h"
+#include "core/utilities/Logger.h"
+#include "utils.h"
 
 namespace wolkabout
 {
-std::vector<std::string> Scanner::s_addr_found = {};
+std::mutex Scanner::s_lock;
+std::vector<Sighting> Scanner::s_addr_found = {};
+ReadingOutlet* Scanner::s_outlet = nullptr;
+std::unordered_set<std::string> Scanner::s_keys = {};
+std::unordered_set<std::string> Scanner::s_foreign_keys = {};
+AdmissionControl Scanner::s_admission;
+void (*Scanner::s_sighting_handler)(const Sighting&, void*) = nullptr;
+void* Scanner::s_sighting_data = nullptr;
+std::unordered_map<std::string, const AdvertisementDecoder*> Scanner::s_decoders = {};
+BeaconIndex Scanner::s_beacons;
+IrkResolver Scanner::s_irks;
+DeviceRegistry Scanner::s_registry;
+std::vector<std::string> Scanner::s_adapter_paths = {"/org/bluez/hci0"};
+std::unordered_map<std::string, Scanner::Tracked> Scanner::s_tracked = {};
+
+bool valid_scan_settings(const ScanSettings& settings)
+{
+    return settings.window > 0 && settings.interval >= settings.window &&
+           settings.rssi_threshold >= ADAPTER_RSSI_MIN && settings.rssi_threshold <= ADAPTER_RSSI_MAX;
+}
 
 Scanner::Scanner() {}
 
@@ -19,35 +40,47 @@ void Scanner::device_disappeared(GDBusConnection* sig, const gchar* sender_name,
     GVariantIter* interfaces;
     const char* object;
     const gchar* interface_name;
-    char address[BT_ADDRESS_STRING_SIZE] = {'\0'};
 
     g_variant_get(parameters, "(&oas)", &object, &interfaces);
     while (g_variant_iter_next(interfaces, "s", &interface_name))
     {
         if (g_strstr_len(g_ascii_strdown(interface_name, -1), -1, "device"))
         {
-            int i;
-            char* tmp = g_strstr_len(object, -1, "dev_") + 4;
-
-            for (i = 0; *tmp != '\0'; i++, tmp++)
-            {
-                if (*tmp == '_')
-                {
-                    address[i] = ':';
-                    continue;
-                }
-                address[i] = *tmp;
-            }
-            auto it = std::find(s_addr_found.begin(), s_addr_found.end(), address);
-            if (it != s_addr_found.end())
-            {
-                s_addr_found.erase(it);
-            }
+            gsize adapter;
+            if (find_adapter(object, adapter))
+                forget(object, adapter);
         }
     }
     return;
 }
 
+void Scanner::forget(const char* object, gsize adapter)
+{
+    char address[BT_ADDRESS_STRING_SIZE] = {'\0'};
+    const char* tmp = g_strstr_len(object, -1, "dev_");
+    if (tmp == NULL)
+        return;
+
+    tmp += 4;
+    for (int i = 0; *tmp != '\0' && i < BT_ADDRESS_STRING_SIZE - 1; i++, tmp++)
+    {
+        if (*tmp == '_')
+        {
+            address[i] = ':';
+            continue;
+        }
+        address[i] = *tmp;
+    }
+
+    std::lock_guard<std::mutex> lock(s_lock);
+    s_tracked.erase(object);
+    s_addr_found.erase(std::remove_if(s_addr_found.begin(), s_addr_found.end(),
+                                      [&](const Sighting& sighting) {
+                                          return sighting.adapter == adapter && sighting.address == address;
+                                      }),
+                       s_addr_found.end());
+}
+
 void Scanner::device_appeared(GDBusConnection* sig, const gchar* sender_name, const gchar* object_path,
                               const gchar* interface, const gchar* signal_name, GVariant* parameters,
                               gpointer user_data)
@@ -63,39 +96,449 @@ void Scanner::device_appeared(GDBusConnection* sig, const gchar* sender_name, co
     const char* object;
     const gchar* interface_name;
     GVariant* properties;
-    int rc;
 
     g_variant_get(parameters, "(&oa{sa{sv}})", &object, &interfaces);
+
+    gsize adapter;
+    if (!find_adapter(object, adapter))
+    {
+        g_variant_iter_free(interfaces);
+        return;
+    }
+
     while (g_variant_iter_next(interfaces, "{&s@a{sv}}", &interface_name, &properties))
     {
-        if (g_strstr_len(g_ascii_strdown(interface_name, -1), -1, "device"))
+        if (!g_strcmp0(interface_name, "org.bluez.Device1"))
+            device_found(object, adapter, properties, false, false);
+        g_variant_unref(properties);
+    }
+    g_variant_iter_free(interfaces);
+    return;
+}
+
+void Scanner::device_found(const char* object, gsize adapter, GVariant* properties, bool cached, bool monitored)
+{
+    const gchar* property_name;
+    GVariantIter i;
+    GVariant* prop_val;
+    std::string address;
+    bool random_address = false;
+    GVariant* manufacturer_data = NULL;
+    GVariant* service_data = NULL;
+    gint16 rssi = 0;
+    gint16 tx_power = 0;
+    bool has_rssi = false;
+    bool has_tx_power = false;
+
+    g_variant_iter_init(&i, properties);
+    while (g_variant_iter_next(&i, "{&sv}", &property_name, &prop_val))
+    {
+        if (!g_strcmp0(property_name, "Address"))
+            address = g_variant_get_string(prop_val, NULL);
+        else if (!g_strcmp0(property_name, "AddressType"))
+            random_address = !g_strcmp0(g_variant_get_string(prop_val, NULL), "random");
+        else if (!g_strcmp0(property_name, "ManufacturerData"))
+            manufacturer_data = g_variant_ref(prop_val);
+        else if (!g_strcmp0(property_name, "ServiceData"))
+            service_data = g_variant_ref(prop_val);
+        else if (!g_strcmp0(property_name, "RSSI") && g_variant_is_of_type(prop_val, G_VARIANT_TYPE_INT16))
+        {
+            rssi = g_variant_get_int16(prop_val);
+            has_rssi = true;
+        }
+        else if (!g_strcmp0(property_name, "TxPower") && g_variant_is_of_type(prop_val, G_VARIANT_TYPE_INT16))
+        {
+            tx_power = g_variant_get_int16(prop_val);
+            has_tx_power = true;
+        }
+        g_variant_unref(prop_val);
+    }
+
+    // Devices BlueZ remembers only carry an RSSI while they are being received
+    const bool in_range = has_rssi || !cached;
+
+    std::string key;
+    bool foreign = false;
+    if (in_range && !s_beacons.empty())
+    {
+        const std::string* beacon = s_beacons.resolve(manufacturer_data, service_data);
+        if (beacon != nullptr && s_foreign_keys.find(*beacon) != s_foreign_keys.end())
+            foreign = true;
+        else if (beacon != nullptr)
+        {
+            key = *beacon;
+            std::lock_guard<std::mutex> lock(s_lock);
+            s_admission.admit();
+        }
+    }
+
+    if (in_range && !foreign && !address.empty() &&
+        (!key.empty() || admit(address, random_address, adapter, key)))
+    {
+        const gint64 seen = coarse_monotonic_time();
+        Sighting sighting{address, key, adapter, seen, seen, monitored};
         {
-            const gchar* property_name;
-            GVariantIter i;
-            GVariant* prop_val;
-            const gchar* value;
-            g_variant_iter_init(&i, properties);
-            while (g_variant_iter_next(&i, "{&sv}", &property_name, &prop_val))
-                if (!(g_strcmp0(property_name, "Address")))
-                {
-                    value = g_variant_get_string(prop_val, NULL);
-                    s_addr_found.push_back(value);
-                }
-            g_variant_unref(prop_val);
+            std::lock_guard<std::mutex> lock(s_lock);
+            const auto known = std::find_if(s_addr_found.begin(), s_addr_found.end(), [&](const Sighting& found) {
+                return found.adapter == adapter && found.address == address;
+            });
+            if (known == s_addr_found.end())
+                s_addr_found.push_back(sighting);
+            else
+            {
+                known->last_seen = seen;
+                known->monitored = known->monitored || monitored;
+                sighting.first_seen = known->first_seen;
+                sighting.monitored = known->monitored;
+            }
+
+            const gsize slot = s_registry.empty() ? DeviceRegistry::NO_SLOT : s_registry.find(key);
+            s_tracked[object] = Tracked{slot, adapter, address, key};
+            if (slot != DeviceRegistry::NO_SLOT)
+                s_registry.record(slot, adapter, has_rssi ? &rssi : NULL, has_tx_power ? &tx_power : NULL);
         }
+
+        if (s_sighting_handler != nullptr)
+        {
+            g_main_context_invoke_full(NULL, G_PRIORITY_DEFAULT, Scanner::dispatch_sighting, new Sighting(sighting),
+                                       Scanner::free_sighting);
+        }
+
+        auto decoder = s_decoders.find(key);
+        if (s_outlet != nullptr && decoder != s_decoders.end())
+        {
+            decode_advertisement(*decoder->second, manufacturer_data, service_data,
+                                 ReadingSink(*s_outlet, decoder->first));
+        }
+    }
+
+    if (manufacturer_data != NULL)
+        g_variant_unref(manufacturer_data);
+    if (service_data != NULL)
+        g_variant_unref(service_data);
+}
+
+void Scanner::sync()
+{
+    g_dbus_connection_call(Bus::connection(), "org.bluez", "/", "org.freedesktop.DBus.ObjectManager",
+                           "GetManagedObjects", NULL, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE, -1,
+                           NULL, Scanner::managed_objects, NULL);
+}
+
+void Scanner::managed_objects(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    (void)user_data;
+
+    GError* error = NULL;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+    {
+        LOG(WARN) << "Unable to list the devices known to BlueZ: " << error->message;
+        g_error_free(error);
+        return;
+    }
+
+    GVariantIter* objects;
+    const char* object;
+    GVariantIter* interfaces;
+    const gchar* interface_name;
+    GVariant* properties;
+    gsize found;
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        found = s_addr_found.size();
+    }
+
+    g_variant_get(reply, "(a{oa{sa{sv}}})", &objects);
+    while (g_variant_iter_next(objects, "{&oa{sa{sv}}}", &object, &interfaces))
+    {
+        gsize adapter;
+        const bool known_adapter = find_adapter(object, adapter);
+        while (g_variant_iter_next(interfaces, "{&s@a{sv}}", &interface_name, &properties))
+        {
+            if (known_adapter && !g_strcmp0(interface_name, "org.bluez.Device1"))
+                device_found(object, adapter, properties, true, false);
+            g_variant_unref(properties);
+        }
+        g_variant_iter_free(interfaces);
+    }
+    g_variant_iter_free(objects);
+    g_variant_unref(reply);
+
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        found = s_addr_found.size() - found;
+    }
+    LOG(INFO) << "Synchronised with BlueZ, " << found << " configured devices in range";
+}
+
+void Scanner::device_changed(GDBusConnection* sig, const gchar* sender_name, const gchar* object_path,
+                             const gchar* interface, const gchar* signal_name, GVariant* parameters,
+                             gpointer user_data)
+{
+    (void)sig;
+    (void)sender_name;
+    (void)interface;
+    (void)signal_name;
+    (void)user_data;
+
+    GVariant* changed = g_variant_get_child_value(parameters, 1);
+    gint16 rssi;
+    gint16 tx_power;
+    const bool has_rssi = g_variant_lookup(changed, "RSSI", "n", &rssi);
+    const bool has_tx_power = g_variant_lookup(changed, "TxPower", "n", &tx_power);
+    GVariant* manufacturer_data = g_variant_lookup_value(changed, "ManufacturerData", G_VARIANT_TYPE("a{qv}"));
+    GVariant* service_data = g_variant_lookup_value(changed, "ServiceData", G_VARIANT_TYPE("a{sv}"));
+    g_variant_unref(changed);
+
+    std::string key;
+    if (has_rssi || manufacturer_data != NULL || service_data != NULL)
+    {
+        const gint64 seen = coarse_monotonic_time();
+        std::lock_guard<std::mutex> lock(s_lock);
+        const auto tracked = s_tracked.find(object_path);
+        if (tracked != s_tracked.end())
+        {
+            key = tracked->second.key;
+            if (has_rssi && tracked->second.slot != DeviceRegistry::NO_SLOT)
+                s_registry.record(tracked->second.slot, tracked->second.adapter, &rssi,
+                                  has_tx_power ? &tx_power : NULL);
+            for (auto& sighting : s_addr_found)
+            {
+                if (sighting.adapter == tracked->second.adapter && sighting.address == tracked->second.address)
+                    sighting.last_seen = seen;
+            }
+        }
+    }
+
+    auto decoder = s_decoders.find(key);
+    if (s_outlet != nullptr && decoder != s_decoders.end() && (manufacturer_data != NULL || service_data != NULL))
+        decode_advertisement(*decoder->second, manufacturer_data, service_data, ReadingSink(*s_outlet, decoder->first));
+
+    if (manufacturer_data != NULL)
+        g_variant_unref(manufacturer_data);
+    if (service_data != NULL)
+        g_variant_unref(service_data);
+}
+
+void Scanner::monitor_found(const char* object)
+{
+    g_dbus_connection_call(Bus::connection(), "org.bluez", object, "org.freedesktop.DBus.Properties", "GetAll",
+                           g_variant_new("(s)", "org.bluez.Device1"), G_VARIANT_TYPE("(a{sv})"),
+                           G_DBUS_CALL_FLAGS_NONE, -1, NULL, Scanner::monitored_properties, g_strdup(object));
+}
+
+void Scanner::monitored_properties(GObject* source, GAsyncResult* result, gpointer user_data)
+{
+    gchar* object = static_cast<gchar*>(user_data);
+
+    GError* error = NULL;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (error != NULL)
+    {
+        LOG(WARN) << "Unable to read the monitored device " << object << ": " << error->message;
+        g_error_free(error);
+        g_free(object);
+        return;
+    }
+
+    gsize adapter;
+    if (find_adapter(object, adapter))
+    {
+        GVariant* properties = g_variant_get_child_value(reply, 0);
+        device_found(object, adapter, properties, false, true);
         g_variant_unref(properties);
     }
-    return;
+    g_variant_unref(reply);
+    g_free(object);
+}
+
+void Scanner::monitor_lost(const char* object)
+{
+    gsize adapter;
+    if (find_adapter(object, adapter))
+        forget(object, adapter);
+}
+
+void Scanner::monitor_released(const std::string& adapter_path)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    for (auto& sighting : s_addr_found)
+    {
+        if (s_adapter_paths[sighting.adapter] == adapter_path)
+            sighting.monitored = false;
+    }
 }
 
-std::vector<std::string> Scanner::getDevices()
+std::vector<Sighting> Scanner::getDevices()
 {
+    std::lock_guard<std::mutex> lock(s_lock);
     return s_addr_found;
 }
 
+void Scanner::reset()
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    s_addr_found.clear();
+    s_tracked.clear();
+}
+
+void Scanner::set_outlet(ReadingOutlet* outlet)
+{
+    s_outlet = outlet;
+}
+
+void Scanner::set_adapters(const std::vector<AdapterZone>& adapters)
+{
+    s_adapter_paths.clear();
+    for (const auto& adapter : adapters)
+        s_adapter_paths.push_back("/org/bluez/" + adapter.adapter);
+    s_registry.set_zones(adapters);
+    s_admission.set_adapters(adapters.size());
+}
+
+void Scanner::add_device_key(const std::string& key)
+{
+    s_keys.insert(key);
+}
+
+void Scanner::add_foreign_key(const std::string& key)
+{
+    s_foreign_keys.insert(key);
+}
+
+void Scanner::set_admission(const AdmissionSettings& settings)
+{
+    s_admission = AdmissionControl(settings);
+    s_admission.set_adapters(s_adapter_paths.size());
+}
+
+void Scanner::set_sighting_handler(void (*f)(const Sighting&, void*), void* user_data)
+{
+    s_sighting_handler = f;
+    s_sighting_data = user_data;
+}
+
+AdmissionControl::Counters Scanner::collect_admission()
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    return s_admission.collect();
+}
+
+bool Scanner::admit(const std::string& address, bool random_address, gsize adapter, std::string& key)
+{
+    if (s_keys.find(address) != s_keys.end())
+    {
+        key = address;
+        std::lock_guard<std::mutex> lock(s_lock);
+        s_admission.admit();
+        return true;
+    }
+
+    // Other shards' devices neither take tokens nor fill the unknown cache
+    if (s_foreign_keys.find(address) != s_foreign_keys.end())
+        return false;
+
+    guint64 value;
+    const bool parsed = parse_address(address, value);
+    const bool resolvable = random_address && !s_irks.empty() && IrkResolver::is_resolvable(address);
+
+    // Addresses resolved before cost no trial, so they take no token
+    const std::string* identity = resolvable ? s_irks.cached(address) : nullptr;
+    if (identity == nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_lock);
+            if (parsed && s_admission.known_unknown(value))
+                return false;
+
+            // Resolving a private address hashes it with every key, so floods are throttled first
+            if (!s_admission.try_admit(adapter))
+                return false;
+        }
+
+        if (resolvable)
+            identity = s_irks.resolve(address);
+    }
+
+    // A private address has to be resolved to tell it belongs to another shard
+    if (identity != nullptr && s_foreign_keys.find(*identity) != s_foreign_keys.end())
+        return false;
+
+    std::lock_guard<std::mutex> lock(s_lock);
+    if (identity != nullptr)
+    {
+        key = *identity;
+        s_admission.admit();
+        return true;
+    }
+
+    if (parsed)
+        s_admission.remember_unknown(value);
+    return false;
+}
+
+gboolean Scanner::dispatch_sighting(gpointer user_data)
+{
+    if (s_sighting_handler != nullptr)
+        s_sighting_handler(*static_cast<const Sighting*>(user_data), s_sighting_data);
+    return G_SOURCE_REMOVE;
+}
+
+void Scanner::free_sighting(gpointer user_data)
+{
+    delete static_cast<Sighting*>(user_data);
+}
+
+bool Scanner::find_adapter(const char* object, gsize& adapter)
+{
+    for (gsize i = 0; i < s_adapter_paths.size(); ++i)
+    {
+        const std::string& path = s_adapter_paths[i];
+        if (g_str_has_prefix(object, path.c_str()) && object[path.size()] == '/')
+        {
+            adapter = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scanner::add_decoder(const std::string& key, const AdvertisementDecoder* decoder)
+{
+    s_decoders[key] = decoder;
+}
+
+void Scanner::add_beacon(const BeaconIdentity& identity, const std::string& key)
+{
+    s_beacons.add(identity, key);
+}
+
+void Scanner::add_irk(const IdentityResolvingKey& irk, const std::string& key)
+{
+    s_irks.add(irk, key);
+}
+
+void Scanner::add_signal_template(const std::string& key, const SignalTemplate& signal)
+{
+    s_registry.add(key, signal);
+}
+
+void Scanner::publish_signals()
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    if (s_outlet != nullptr)
+        s_registry.publish(*s_outlet);
+}
+
 int Scanner::add_timer(unsigned interval, int (*f)(void*), void* user_data)
 {
     return g_timeout_add_seconds(interval, f, user_data);
 }
 
+void Scanner::remove_timer(int timer)
+{
+    g_source_remove(static_cast<guint>(timer));
+}
+
 }    // namespace wolkabout
\ No newline at end of file
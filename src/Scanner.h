@@ -2,19 +2,62 @@
 #define SCANNER_H
 
 #include "Adapter.h"
-#include "Wolk.h"
+#include "AdmissionControl.h"
+#include "AdvertisementDecoder.h"
+#include "BeaconIdentity.h"
+#include "DeviceRegistry.h"
+#include "IrkResolver.h"
+#include "ReadingOutlet.h"
 
 #include <algorithm>
 #include <gio/gio.h>
 #include <glib.h>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #define BT_ADDRESS_STRING_SIZE 18
 
 namespace wolkabout
 {
+/**
+ * A device seen during the scan. `key` is the configured device key the
+ * sighting resolved to, which is the address unless the device was
+ * identified by its beacon identity or resolvable private address.
+ * `adapter` is the index of the adapter that saw it. `first_seen` and
+ * `last_seen` are the coarse monotonic times it was first and last received
+ * since BlueZ discovered it. `monitored` sightings are held by an
+ * advertisement monitor, which reports when the device is lost, and stay
+ * present until then.
+ */
+struct Sighting
+{
+    std::string address;
+    std::string key;
+    gsize adapter;
+    gint64 first_seen;
+    gint64 last_seen;
+    bool monitored;
+};
+
+/**
+ * Scan cycle: discovery runs for `window` seconds out of every `interval`
+ * seconds. A device stays present for `absence_timeout` seconds after it was
+ * last seen, zero meaning it must be seen in every window.
+ */
+struct ScanSettings
+{
+    unsigned interval;
+    unsigned window;
+    int rssi_threshold;
+    unsigned absence_timeout;
+};
+
+bool valid_scan_settings(const ScanSettings& settings);
+
 class Scanner
 {
 public:
@@ -28,11 +71,150 @@ public:
                                 const gchar* interface, const gchar* signal_name, GVariant* parameters,
                                 gpointer user_data);
 
-    static std::vector<std::string> getDevices();
+    /**
+     * Feeds the devices BlueZ already knows and currently receives into the
+     * sighting path, as if they had just appeared. Used at startup and after
+     * bluetoothd restarted, when no InterfacesAdded is sent for them.
+     */
+    static void sync();
+
+    /**
+     * Counts RSSI updates of already discovered devices as sightings, which
+     * moves their last detection time. Devices BlueZ keeps between windows,
+     * such as those polled over GATT, are only detected again this way.
+     * Changed manufacturer or service data is decoded like a new advertisement,
+     * since such devices stay known and are never discovered again.
+     * Changes are routed to the worker of the adapter that owns the device.
+     */
+    static void device_changed(GDBusConnection* sig, const gchar* sender_name, const gchar* object_path,
+                               const gchar* interface, const gchar* signal_name, GVariant* parameters,
+                               gpointer user_data);
+
+    /**
+     * An advertisement monitor matched the device, its properties are fetched
+     * and it is held as a sighting until the monitor loses it.
+     */
+    static void monitor_found(const char* object);
+
+    static void monitor_lost(const char* object);
+
+    /**
+     * The adapter's monitor was released, its sightings are no longer held.
+     */
+    static void monitor_released(const std::string& adapter_path);
+
+    static std::vector<Sighting> getDevices();
+
+    /**
+     * Forgets the devices known to BlueZ, after bluetoothd restarted.
+     */
+    static void reset();
+
+    static void set_outlet(ReadingOutlet* outlet);
+
+    /**
+     * Registers the adapters sightings are accepted from, with the zone each
+     * covers. Must be called before signal templates are added.
+     */
+    static void set_adapters(const std::vector<AdapterZone>& adapters);
+
+    /**
+     * Sightings resolving to a key that was not added are shed by admission
+     * control and never reported.
+     */
+    static void add_device_key(const std::string& key);
+
+    /**
+     * Keys of devices owned by other shards. Their sightings are dropped
+     * before admission control and not counted. Their beacon identities and
+     * IRKs are added like those of the own devices, so sightings resolve to
+     * these keys.
+     */
+    static void add_foreign_key(const std::string& key);
+
+    static void set_admission(const AdmissionSettings& settings);
+
+    /**
+     * Called for every admitted sighting as it arrives, on the main loop
+     * whichever adapter thread received it.
+     */
+    static void set_sighting_handler(void (*f)(const Sighting&, void*), void* user_data);
+
+    /**
+     * Admission counters since the last call.
+     */
+    static AdmissionControl::Counters collect_admission();
+
+    static void add_decoder(const std::string& key, const AdvertisementDecoder* decoder);
+
+    static void add_beacon(const BeaconIdentity& identity, const std::string& key);
+
+    static void add_irk(const IdentityResolvingKey& irk, const std::string& key);
+
+    static void add_signal_template(const std::string& key, const SignalTemplate& signal);
+
+    static void publish_signals();
 
     int add_timer(unsigned interval, int (*f)(void*), void* user_data);
 
-    static std::vector<std::string> s_addr_found;
+    void remove_timer(int timer);
+
+    static std::vector<Sighting> s_addr_found;
+
+private:
+    // Guards the sightings, tracked devices, registry and admission control, which are shared by the adapter
+    // threads. Everything else is only written before the adapters start.
+    static std::mutex s_lock;
+
+    static ReadingOutlet* s_outlet;
+
+    static std::unordered_set<std::string> s_keys;
+
+    static std::unordered_set<std::string> s_foreign_keys;
+
+    static AdmissionControl s_admission;
+
+    static void (*s_sighting_handler)(const Sighting&, void*);
+
+    static void* s_sighting_data;
+
+    static std::unordered_map<std::string, const AdvertisementDecoder*> s_decoders;
+
+    static BeaconIndex s_beacons;
+
+    static IrkResolver s_irks;
+
+    static DeviceRegistry s_registry;
+
+    static std::vector<std::string> s_adapter_paths;
+
+    struct Tracked
+    {
+        gsize slot;
+        gsize adapter;
+        std::string address;
+        std::string key;
+    };
+
+    // Admitted devices currently known to BlueZ with their registry slot, NO_SLOT without signal sensors, by
+    // object path
+    static std::unordered_map<std::string, Tracked> s_tracked;
+
+    static bool find_adapter(const char* object, gsize& adapter);
+
+    static void device_found(const char* object, gsize adapter, GVariant* properties, bool cached, bool monitored);
+
+    static void forget(const char* object, gsize adapter);
+
+    static void managed_objects(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    static void monitored_properties(GObject* source, GAsyncResult* result, gpointer user_data);
+
+    static gboolean dispatch_sighting(gpointer user_data);
+
+    static void free_sighting(gpointer user_data);
+
+    static bool admit(const std::string& address, bool random_address, gsize adapter, std::string& key);
 };
 
 }    // namespace wolkabout
@@ -0,0 +1,51 @@
+#include "Shard.h"
+
+#include <cstdlib>
+
+namespace wolkabout
+{
+bool valid_shard_settings(const ShardSettings& settings)
+{
+    return settings.count > 0 && settings.index < settings.count;
+}
+
+bool parse_shard(const std::string& text, ShardSettings& settings)
+{
+    if (text.empty() || text.find_first_not_of("0123456789/") != std::string::npos)
+    {
+        return false;
+    }
+
+    char* end = NULL;
+    settings.index = static_cast<unsigned>(strtoul(text.c_str(), &end, 10));
+    if (end == text.c_str() || *end != '/' || *(end + 1) == '\0')
+    {
+        return false;
+    }
+
+    const char* count = end + 1;
+    settings.count = static_cast<unsigned>(strtoul(count, &end, 10));
+    return end != count && *end == '\0' && valid_shard_settings(settings);
+}
+
+unsigned shard_of(const std::string& key, unsigned count)
+{
+    unsigned hash = 2166136261u;
+    for (unsigned char c : key)
+    {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash % count;
+}
+
+std::string shard_path(const std::string& path, const ShardSettings& settings)
+{
+    if (path.empty() || settings.count < 2)
+    {
+        return path;
+    }
+    return path + "." + std::to_string(settings.index);
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,38 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * Devices are split between `count` instances sharing one configuration,
+ * each owning the devices whose key hashes to its `index`.
+ */
+struct ShardSettings
+{
+    unsigned index;
+    unsigned count;
+};
+
+bool valid_shard_settings(const ShardSettings& settings);
+
+/**
+ * Parses "<index>/<count>", for example "0/4".
+ */
+bool parse_shard(const std::string& text, ShardSettings& settings);
+
+/**
+ * Shard of the device key. The hash is 32 bit FNV-1a of the key and must stay
+ * the same across releases, so instances of different versions agree.
+ */
+unsigned shard_of(const std::string& key, unsigned count);
+
+/**
+ * The path with ".<index>" appended when there is more than one shard, so
+ * instances keep their state files apart.
+ */
+std::string shard_path(const std::string& path, const ShardSettings& settings);
+
+}    // namespace wolkabout
+#endif
@@ -0,0 +1,24 @@
+#include "TokenBucket.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+TokenBucket::TokenBucket(double rate, double burst, gint64 now)
+: tokens_per_usec(rate / G_USEC_PER_SEC), capacity(burst), tokens(burst), updated(now)
+{
+}
+
+bool TokenBucket::take(gint64 now)
+{
+    tokens = std::min(capacity, tokens + static_cast<double>(now - updated) * tokens_per_usec);
+    updated = now;
+
+    if (tokens < 1)
+        return false;
+
+    tokens -= 1;
+    return true;
+}
+
+}    // namespace wolkabout
@@ -0,0 +1,27 @@
+#ifndef TOKENBUCKET_H
+#define TOKENBUCKET_H
+
+#include <glib.h>
+
+namespace wolkabout
+{
+/**
+ * Allows `rate` events per second on average and bursts of up to `burst`
+ * events. Times are monotonic microseconds.
+ */
+class TokenBucket
+{
+public:
+    TokenBucket(double rate, double burst, gint64 now = g_get_monotonic_time());
+
+    bool take(gint64 now = g_get_monotonic_time());
+
+private:
+    double tokens_per_usec;
+    double capacity;
+    double tokens;
+    gint64 updated;
+};
+
+}    // namespace wolkabout
+#endif
@@ -1,5 +1,7 @@
 #include "utils.h"
 
+#include <time.h>
+
 namespace wolkabout
 {
 void free_properties(GVariantIter* properties, GVariant* value)
@@ -12,18 +14,51 @@ void free_properties(GVariantIter* properties, GVariant* value)
     return;
 }
 
-std::string to_object(std::string address)
+std::string to_object(std::string address, const std::string& adapter_path)
 {
-    std::string pre = "/org/bluez/hci0/dev_";
+    std::string pre = adapter_path + "/dev_";
     std::replace(address.begin(), address.end(), ':', '_');
     pre.append(address);
     return pre;
 }
 
+bool parse_address(const std::string& address, guint64& value)
+{
+    if (address.size() != 17)
+        return false;
+
+    value = 0;
+    for (gsize i = 0; i < address.size(); ++i)
+    {
+        if (i % 3 == 2)
+        {
+            if (address[i] != ':')
+                return false;
+            continue;
+        }
+
+        const int digit = g_ascii_xdigit_value(address[i]);
+        if (digit < 0)
+            return false;
+        value = (value << 4) | static_cast<guint64>(digit);
+    }
+    return true;
+}
+
 std::string str_toupper(std::string s)
 {
     std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::toupper(c); });
     return s;
 }
 
+gint64 coarse_monotonic_time()
+{
+#ifdef CLOCK_MONOTONIC_COARSE
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC_COARSE, &now) == 0)
+        return static_cast<gint64>(now.tv_sec) * G_USEC_PER_SEC + now.tv_nsec / 1000;
+#endif
+    return g_get_monotonic_time();
+}
+
 }    // namespace wolkabout
\ No newline at end of file
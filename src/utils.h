@@ -11,9 +11,21 @@ namespace wolkabout
 {
 void free_properties(GVariantIter* properties, GVariant* value);
 
-std::string to_object(std::string address);
+std::string to_object(std::string address, const std::string& adapter_path = "/org/bluez/hci0");
 
 std::string str_toupper(std::string s);
 
+/**
+ * Parses a "XX:XX:XX:XX:XX:XX" address into its 48 bit value.
+ */
+bool parse_address(const std::string& address, guint64& value);
+
+/**
+ * Microseconds of the coarse monotonic clock. It is read from the vDSO
+ * without a system call and advances with the scheduler tick, which is
+ * precise enough to stamp every sighting.
+ */
+gint64 coarse_monotonic_time();
+
 }    // namespace wolkabout
 #endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AdmissionControl.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+// Slow enough that no token is refilled while a test runs
+const wolkabout::AdmissionSettings SETTINGS = {0.001, 2, 3};
+}    // namespace
+
+TEST(AdmissionControl, Given_DefaultSettings_When_Validated_Then_TheyAreValid)
+{
+    ASSERT_TRUE(wolkabout::valid_admission_settings(wolkabout::AdmissionControl::DEFAULT_SETTINGS));
+}
+
+TEST(AdmissionControl, Given_InvalidSettings_When_Validated_Then_TheyAreRejected)
+{
+    ASSERT_FALSE(wolkabout::valid_admission_settings({0, 2, 3}));
+    ASSERT_FALSE(wolkabout::valid_admission_settings({1, 0.5, 3}));
+    ASSERT_FALSE(wolkabout::valid_admission_settings({1, 2, 0}));
+}
+
+TEST(AdmissionControl, Given_Burst_When_ItIsExhausted_Then_SightingsAreThrottledAndCounted)
+{
+    // Given
+    wolkabout::AdmissionControl admission(SETTINGS);
+
+    // When
+    const bool first = admission.try_admit(0);
+    const bool second = admission.try_admit(0);
+    const bool third = admission.try_admit(0);
+
+    // Then
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    ASSERT_FALSE(third);
+    ASSERT_EQ(admission.collect().throttled, 1u);
+}
+
+TEST(AdmissionControl, Given_TwoAdapters_When_OneIsFlooded_Then_TheOtherStillAdmits)
+{
+    // Given
+    wolkabout::AdmissionControl admission(SETTINGS);
+    admission.set_adapters(2);
+
+    // When
+    admission.try_admit(0);
+    admission.try_admit(0);
+    admission.try_admit(0);
+
+    // Then
+    ASSERT_TRUE(admission.try_admit(1));
+}
+
+TEST(AdmissionControl, Given_UnknownAdapter_When_Admitting_Then_TheFirstBucketIsUsed)
+{
+    // Given
+    wolkabout::AdmissionControl admission(SETTINGS);
+    admission.try_admit(0);
+    admission.try_admit(0);
+
+    // When
+    const bool admitted = admission.try_admit(5);
+
+    // Then
+    ASSERT_FALSE(admitted);
+}
+
+TEST(AdmissionControl, Given_RememberedAddress_When_SeenAgain_Then_ItIsIgnoredAndCounted)
+{
+    // Given
+    wolkabout::AdmissionControl admission(SETTINGS);
+    admission.remember_unknown(0x112233445566);
+
+    // When
+    const bool known = admission.known_unknown(0x112233445566);
+    const bool other = admission.known_unknown(0x665544332211);
+
+    // Then
+    ASSERT_TRUE(known);
+    ASSERT_FALSE(other);
+    const auto counters = admission.collect();
+    ASSERT_EQ(counters.unknown, 1u);
+    ASSERT_EQ(counters.ignored, 1u);
+}
+
+TEST(AdmissionControl, Given_FullCache_When_ANewAddressIsRemembered_Then_TheLeastRecentlySeenIsEvicted)
+{
+    // Given
+    wolkabout::AdmissionControl admission(SETTINGS);
+    admission.remember_unknown(1);
+    admission.remember_unknown(2);
+    admission.remember_unknown(3);
+
+    // When
+    admission.known_unknown(1);
+    admission.remember_unknown(4);
+
+    // Then
+    ASSERT_TRUE(admission.known_unknown(1));
+    ASSERT_FALSE(admission.known_unknown(2));
+    ASSERT_TRUE(admission.known_unknown(3));
+    ASSERT_TRUE(admission.known_unknown(4));
+}
+
+TEST(AdmissionControl, Given_RememberedAddress_When_RememberedAgain_Then_ItIsCountedOnce)
+{
+    // Given
+    wolkabout::AdmissionControl admission(SETTINGS);
+    admission.remember_unknown(1);
+
+    // When
+    admission.remember_unknown(1);
+
+    // Then
+    ASSERT_EQ(admission.collect().unknown, 1u);
+}
+
+TEST(AdmissionControl, Given_Counters_When_Collected_Then_TheyAreReset)
+{
+    // Given
+    wolkabout::AdmissionControl admission(SETTINGS);
+    admission.admit();
+    admission.admit();
+
+    // When
+    const auto collected = admission.collect();
+
+    // Then
+    ASSERT_EQ(collected.admitted, 2u);
+    ASSERT_EQ(admission.collect().admitted, 0u);
+}
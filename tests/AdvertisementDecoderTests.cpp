@@ -0,0 +1,196 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AdvertisementDecoder.h"
+#include "AdvertisementDecoders.h"
+
+#include <glib.h>
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+struct Reading
+{
+    double value;
+    bool integral;
+};
+
+class RecordingSink
+{
+public:
+    template <typename T> void operator()(const char* reference, T value) const
+    {
+        readings[reference] = Reading{static_cast<double>(value), std::is_integral<T>::value};
+    }
+
+    mutable std::map<std::string, Reading> readings;
+};
+
+std::vector<guint8> bytes(const std::string& hex)
+{
+    std::vector<guint8> data;
+    for (std::string::size_type i = 0; i + 1 < hex.size(); i += 2)
+    {
+        data.push_back(static_cast<guint8>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+    }
+    return data;
+}
+
+template <typename Decoder> bool decode(const std::string& hex, const RecordingSink& sink)
+{
+    const std::vector<guint8> data = bytes(hex);
+    return Decoder::decode(data.data(), data.size(), sink);
+}
+}    // namespace
+
+TEST(AdvertisementDecoder, Given_RuuviRawV2Sample_When_Decoded_Then_AllValuesAreRead)
+{
+    // Given
+    RecordingSink sink;
+
+    // When
+    const bool decoded =
+      decode<wolkabout::decoders::RuuviRawV2>("0512FC5394C37C0004FFFC040CAC364200CDCBB8334C884F", sink);
+
+    // Then
+    ASSERT_TRUE(decoded);
+    ASSERT_EQ(sink.readings.size(), 8u);
+    ASSERT_NEAR(sink.readings["T"].value, 24.3, 1e-9);
+    ASSERT_NEAR(sink.readings["H"].value, 53.49, 1e-9);
+    ASSERT_NEAR(sink.readings["PR"].value, 1000.44, 1e-9);
+    ASSERT_NEAR(sink.readings["AX"].value, 0.004, 1e-9);
+    ASSERT_NEAR(sink.readings["AY"].value, -0.004, 1e-9);
+    ASSERT_NEAR(sink.readings["AZ"].value, 1.036, 1e-9);
+    ASSERT_EQ(sink.readings["BV"].value, 2977);
+    ASSERT_TRUE(sink.readings["BV"].integral);
+    ASSERT_EQ(sink.readings["MC"].value, 66);
+    ASSERT_TRUE(sink.readings["MC"].integral);
+}
+
+TEST(AdvertisementDecoder, Given_RuuviRawV2WithInvalidValues_When_Decoded_Then_NoValueIsRead)
+{
+    RecordingSink sink;
+
+    ASSERT_TRUE(decode<wolkabout::decoders::RuuviRawV2>("058000FFFFFFFF800080008000FFFFFFFFFFFFFFFFFFFFFF", sink));
+    ASSERT_TRUE(sink.readings.empty());
+}
+
+TEST(AdvertisementDecoder, Given_OtherRuuviFormat_When_Decoded_Then_ItIsRejected)
+{
+    RecordingSink sink;
+
+    ASSERT_FALSE(decode<wolkabout::decoders::RuuviRawV2>("0312FC5394C37C0004FFFC040CAC364200CD", sink));
+    ASSERT_FALSE(decode<wolkabout::decoders::RuuviRawV2>("0512FC5394C37C", sink));
+    ASSERT_TRUE(sink.readings.empty());
+}
+
+TEST(AdvertisementDecoder, Given_EddystoneTlmFrame_When_Decoded_Then_AllValuesAreRead)
+{
+    // Given
+    RecordingSink sink;
+
+    // When
+    const bool decoded = decode<wolkabout::decoders::EddystoneTlm>("20000BB8188000000010000003E8", sink);
+
+    // Then
+    ASSERT_TRUE(decoded);
+    ASSERT_EQ(sink.readings.size(), 3u);
+    ASSERT_EQ(sink.readings["BV"].value, 3000);
+    ASSERT_DOUBLE_EQ(sink.readings["T"].value, 24.5);
+    ASSERT_EQ(sink.readings["UP"].value, 100);
+    ASSERT_TRUE(sink.readings["UP"].integral);
+}
+
+TEST(AdvertisementDecoder, Given_OtherEddystoneFrame_When_Decoded_Then_ItIsRejected)
+{
+    RecordingSink sink;
+
+    ASSERT_FALSE(decode<wolkabout::decoders::EddystoneTlm>("10000BB8188000000010000003E8", sink));
+    ASSERT_FALSE(decode<wolkabout::decoders::EddystoneTlm>("20000BB81880", sink));
+    ASSERT_TRUE(sink.readings.empty());
+}
+
+TEST(AdvertisementDecoder, Given_Atc1441Payload_When_Decoded_Then_BigEndianValuesAreRead)
+{
+    // Given
+    RecordingSink sink;
+
+    // When
+    const bool decoded = decode<wolkabout::decoders::Atc>("A4C138010203" "00EB32550B8A01", sink);
+
+    // Then
+    ASSERT_TRUE(decoded);
+    ASSERT_EQ(sink.readings.size(), 4u);
+    ASSERT_DOUBLE_EQ(sink.readings["T"].value, 23.5);
+    ASSERT_EQ(sink.readings["H"].value, 50);
+    ASSERT_EQ(sink.readings["B"].value, 85);
+    ASSERT_EQ(sink.readings["BV"].value, 2954);
+}
+
+TEST(AdvertisementDecoder, Given_PvvxPayload_When_Decoded_Then_LittleEndianValuesAreRead)
+{
+    // Given
+    RecordingSink sink;
+
+    // When
+    const bool decoded = decode<wolkabout::decoders::Atc>("03020138C1A4" "92098813B80B5A0100", sink);
+
+    // Then
+    ASSERT_TRUE(decoded);
+    ASSERT_EQ(sink.readings.size(), 4u);
+    ASSERT_DOUBLE_EQ(sink.readings["T"].value, 24.5);
+    ASSERT_DOUBLE_EQ(sink.readings["H"].value, 50.0);
+    ASSERT_EQ(sink.readings["BV"].value, 3000);
+    ASSERT_EQ(sink.readings["B"].value, 90);
+}
+
+TEST(AdvertisementDecoder, Given_AtcPayloadOfUnknownLength_When_Decoded_Then_ItIsRejected)
+{
+    RecordingSink sink;
+
+    ASSERT_FALSE(decode<wolkabout::decoders::Atc>("A4C13801020300EB32550B8A0102", sink));
+    ASSERT_TRUE(sink.readings.empty());
+}
+
+TEST(AdvertisementDecoder, Given_BatteryLevel_When_Decoded_Then_OnlyPercentagesAreAccepted)
+{
+    RecordingSink sink;
+
+    ASSERT_TRUE(decode<wolkabout::decoders::BatteryLevel>("64", sink));
+    ASSERT_EQ(sink.readings["B"].value, 100);
+
+    sink.readings.clear();
+    ASSERT_FALSE(decode<wolkabout::decoders::BatteryLevel>("65", sink));
+    ASSERT_FALSE(decode<wolkabout::decoders::BatteryLevel>("", sink));
+    ASSERT_TRUE(sink.readings.empty());
+}
+
+TEST(AdvertisementDecoder, Given_DecoderNames_When_Found_Then_OnlyKnownFormatsAreReturned)
+{
+    for (const char* name : {"ruuvi", "eddystone_tlm", "atc", "battery"})
+    {
+        const wolkabout::AdvertisementDecoder* decoder = wolkabout::find_decoder(name);
+        ASSERT_NE(decoder, nullptr) << name;
+        ASSERT_STREQ(decoder->name, name);
+    }
+
+    ASSERT_EQ(wolkabout::find_decoder("unknown"), nullptr);
+    ASSERT_EQ(wolkabout::find_decoder(""), nullptr);
+}
@@ -0,0 +1,368 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Adapter.h"
+#include "AdapterWorker.h"
+#include "AdvertisementMonitor.h"
+#include "Bus.h"
+#include "Scanner.h"
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+namespace
+{
+const char* const DEVICE_ADDRESS = "AA:BB:CC:DD:EE:FF";
+const char* const DEVICE_PATH = "/org/bluez/hci0/dev_AA_BB_CC_DD_EE_FF";
+
+// The parts of bluetoothd the monitor and the adapter worker talk to
+const char* const BLUEZ_INTROSPECTION = "<node>"
+                                        "  <interface name='org.bluez.AdvertisementMonitorManager1'>"
+                                        "    <method name='RegisterMonitor'>"
+                                        "      <arg name='application' type='o' direction='in'/>"
+                                        "    </method>"
+                                        "    <method name='UnregisterMonitor'>"
+                                        "      <arg name='application' type='o' direction='in'/>"
+                                        "    </method>"
+                                        "  </interface>"
+                                        "  <interface name='org.bluez.Adapter1'>"
+                                        "    <method name='StartDiscovery'/>"
+                                        "    <method name='StopDiscovery'/>"
+                                        "  </interface>"
+                                        "  <interface name='org.bluez.Device1'>"
+                                        "    <property name='Address' type='s' access='read'/>"
+                                        "    <property name='AddressType' type='s' access='read'/>"
+                                        "    <property name='RSSI' type='n' access='read'/>"
+                                        "  </interface>"
+                                        "</node>";
+
+/**
+ * Stub bluetoothd owning org.bluez on the test bus. Records what the module
+ * asks of it and calls the registered monitor on request.
+ */
+struct Bluez
+{
+    GDBusConnection* connection = nullptr;
+    GDBusNodeInfo* introspection = nullptr;
+    std::vector<guint> registrations;
+
+    std::string owner;
+    std::string application;
+    std::string monitor;
+    std::string monitor_type;
+    int discovery_started = 0;
+    int discovery_stopped = 0;
+    int replies = 0;
+
+    static void method_call(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                            const gchar* interface, const gchar* method, GVariant* parameters,
+                            GDBusMethodInvocation* invocation, gpointer user_data)
+    {
+        (void)object_path;
+        (void)interface;
+
+        Bluez* bluez = static_cast<Bluez*>(user_data);
+        if (!g_strcmp0(method, "RegisterMonitor"))
+        {
+            const gchar* application;
+            g_variant_get(parameters, "(&o)", &application);
+            bluez->owner = sender;
+            bluez->application = application;
+
+            // bluetoothd reads the monitors of the application before activating them
+            g_dbus_connection_call(connection, sender, application, "org.freedesktop.DBus.ObjectManager",
+                                   "GetManagedObjects", NULL, G_VARIANT_TYPE("(a{oa{sa{sv}}})"),
+                                   G_DBUS_CALL_FLAGS_NONE, -1, NULL, Bluez::managed_objects, bluez);
+        }
+        else if (!g_strcmp0(method, "UnregisterMonitor"))
+            bluez->application.clear();
+        else if (!g_strcmp0(method, "StartDiscovery"))
+            ++bluez->discovery_started;
+        else if (!g_strcmp0(method, "StopDiscovery"))
+            ++bluez->discovery_stopped;
+        g_dbus_method_invocation_return_value(invocation, NULL);
+    }
+
+    static GVariant* get_property(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                                  const gchar* interface, const gchar* property, GError** error, gpointer user_data)
+    {
+        (void)connection;
+        (void)sender;
+        (void)object_path;
+        (void)interface;
+        (void)error;
+        (void)user_data;
+
+        if (!g_strcmp0(property, "Address"))
+            return g_variant_new_string(DEVICE_ADDRESS);
+        if (!g_strcmp0(property, "AddressType"))
+            return g_variant_new_string("public");
+        return g_variant_new_int16(-60);
+    }
+
+    static void managed_objects(GObject* source, GAsyncResult* result, gpointer user_data)
+    {
+        Bluez* bluez = static_cast<Bluez*>(user_data);
+        GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, NULL);
+        ASSERT_NE(reply, nullptr);
+
+        GVariantIter* objects;
+        const gchar* object;
+        GVariant* interfaces;
+        g_variant_get(reply, "(a{oa{sa{sv}}})", &objects);
+        while (g_variant_iter_next(objects, "{&o@a{sa{sv}}}", &object, &interfaces))
+        {
+            GVariant* properties =
+              g_variant_lookup_value(interfaces, "org.bluez.AdvertisementMonitor1", G_VARIANT_TYPE("a{sv}"));
+            if (properties != NULL)
+            {
+                const gchar* type;
+                if (g_variant_lookup(properties, "Type", "&s", &type))
+                    bluez->monitor_type = type;
+                bluez->monitor = object;
+                g_variant_unref(properties);
+            }
+            g_variant_unref(interfaces);
+        }
+        g_variant_iter_free(objects);
+        g_variant_unref(reply);
+    }
+
+    static void replied(GObject* source, GAsyncResult* result, gpointer user_data)
+    {
+        GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, NULL);
+        if (reply != NULL)
+            g_variant_unref(reply);
+        ++static_cast<Bluez*>(user_data)->replies;
+    }
+
+    void export_objects()
+    {
+        static const GDBusInterfaceVTable vtable = {Bluez::method_call, Bluez::get_property, NULL, {0}};
+        introspection = g_dbus_node_info_new_for_xml(BLUEZ_INTROSPECTION, NULL);
+        for (const char* interface : {"org.bluez.AdvertisementMonitorManager1", "org.bluez.Adapter1"})
+        {
+            registrations.push_back(g_dbus_connection_register_object(
+              connection, "/org/bluez/hci0", g_dbus_node_info_lookup_interface(introspection, interface), &vtable,
+              this, NULL, NULL));
+        }
+        registrations.push_back(g_dbus_connection_register_object(
+          connection, DEVICE_PATH, g_dbus_node_info_lookup_interface(introspection, "org.bluez.Device1"), &vtable,
+          this, NULL, NULL));
+    }
+
+    void unexport_objects()
+    {
+        for (guint registration : registrations)
+            g_dbus_connection_unregister_object(connection, registration);
+        registrations.clear();
+        g_dbus_node_info_unref(introspection);
+    }
+
+    void call_monitor(const char* method, GVariant* parameters)
+    {
+        g_dbus_connection_call(connection, owner.c_str(), monitor.c_str(), "org.bluez.AdvertisementMonitor1", method,
+                               parameters, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, Bluez::replied, this);
+    }
+};
+
+GDBusConnection* connect(const gchar* address)
+{
+    const GDBusConnectionFlags flags = static_cast<GDBusConnectionFlags>(
+      G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION);
+    return g_dbus_connection_new_for_address_sync(address, flags, NULL, NULL, NULL);
+}
+
+class AdvertisementMonitor : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+        g_test_dbus_up(bus);
+
+        bluez.connection = connect(g_test_dbus_get_bus_address(bus));
+        GVariant* reply = g_dbus_connection_call_sync(
+          bluez.connection, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "RequestName",
+          g_variant_new("(su)", "org.bluez", 0u), NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+        ASSERT_NE(reply, nullptr);
+        g_variant_unref(reply);
+        bluez.export_objects();
+
+        GDBusConnection* module = connect(g_test_dbus_get_bus_address(bus));
+        wolkabout::Bus::set_connection(module);
+        g_object_unref(module);
+
+        wolkabout::Scanner::reset();
+        wolkabout::Scanner::set_adapters({wolkabout::AdapterZone{"hci0", 0, false, 0, 0}});
+        wolkabout::Scanner::add_device_key(DEVICE_ADDRESS);
+
+        adapter.reset(new wolkabout::Adapter("hci0"));
+        worker.reset(new wolkabout::AdapterWorker(*adapter, wolkabout::Scanner::device_appeared,
+                                                  wolkabout::Scanner::device_disappeared,
+                                                  wolkabout::Scanner::device_changed));
+        worker->start();
+
+        wolkabout::MonitorPattern pattern{0, 0xFF, {0x4C, 0x00, 0x02, 0x15}};
+        monitor.reset(new wolkabout::AdvertisementMonitor(*adapter, {pattern}, AdvertisementMonitor::changed, this));
+    }
+
+    void TearDown() override
+    {
+        monitor.reset();
+        worker.reset();
+        adapter.reset();
+        wolkabout::Scanner::reset();
+        wolkabout::Bus::set_connection(nullptr);
+
+        bluez.unexport_objects();
+        g_object_unref(bluez.connection);
+        g_test_dbus_down(bus);
+        g_object_unref(bus);
+    }
+
+    static void changed(bool active, void* user_data)
+    {
+        AdvertisementMonitor* test = static_cast<AdvertisementMonitor*>(user_data);
+        test->activations.push_back(active);
+        test->worker->set_monitored(active);
+    }
+
+    // Runs the main loop until `done` holds or `timeout` microseconds passed
+    template <typename Predicate> bool wait_for(Predicate done, gint64 timeout = 5 * G_USEC_PER_SEC)
+    {
+        const gint64 deadline = g_get_monotonic_time() + timeout;
+        while (!done() && g_get_monotonic_time() < deadline)
+        {
+            if (!g_main_context_iteration(NULL, FALSE))
+                g_usleep(1000);
+        }
+        return done();
+    }
+
+    void call(const char* method, GVariant* parameters = NULL)
+    {
+        const int replies = bluez.replies;
+        bluez.call_monitor(method, parameters);
+        ASSERT_TRUE(wait_for([&] { return bluez.replies > replies; }));
+    }
+
+    void activate()
+    {
+        monitor->register_monitor();
+        ASSERT_TRUE(wait_for([&] { return !bluez.monitor.empty(); }));
+        call("Activate");
+    }
+
+    bool device_held()
+    {
+        for (const auto& sighting : wolkabout::Scanner::getDevices())
+        {
+            if (sighting.address == DEVICE_ADDRESS && sighting.monitored)
+                return true;
+        }
+        return false;
+    }
+
+    GTestDBus* bus;
+    Bluez bluez;
+    std::unique_ptr<wolkabout::Adapter> adapter;
+    std::unique_ptr<wolkabout::AdapterWorker> worker;
+    std::unique_ptr<wolkabout::AdvertisementMonitor> monitor;
+    std::vector<bool> activations;
+};
+}    // namespace
+
+TEST_F(AdvertisementMonitor, Given_Monitor_When_Registered_Then_BluezReadsAnOrPatternsMonitor)
+{
+    // When
+    monitor->register_monitor();
+
+    // Then
+    ASSERT_TRUE(wait_for([&] { return !bluez.monitor.empty(); }));
+    ASSERT_EQ(bluez.application, "/org/wolkabout/bluetooth/hci0");
+    ASSERT_EQ(bluez.monitor, "/org/wolkabout/bluetooth/hci0/monitor0");
+    ASSERT_EQ(bluez.monitor_type, "or_patterns");
+    ASSERT_FALSE(monitor->active());
+}
+
+TEST_F(AdvertisementMonitor, Given_RegisteredMonitor_When_Activated_Then_HandlerIsCalledAndDiscoveryStops)
+{
+    // Given
+    worker->start_scan();
+    ASSERT_TRUE(wait_for([&] { return bluez.discovery_started == 1; }));
+
+    // When
+    activate();
+
+    // Then
+    ASSERT_TRUE(monitor->active());
+    ASSERT_EQ(activations, std::vector<bool>{true});
+    ASSERT_TRUE(wait_for([&] { return bluez.discovery_stopped == 1; }));
+}
+
+TEST_F(AdvertisementMonitor, Given_ActiveMonitor_When_DeviceIsFoundAndLost_Then_ItIsHeldUntilLost)
+{
+    // Given
+    activate();
+
+    // When
+    call("DeviceFound", g_variant_new("(o)", DEVICE_PATH));
+
+    // Then
+    ASSERT_TRUE(wait_for([&] { return device_held(); }));
+
+    // When
+    call("DeviceLost", g_variant_new("(o)", DEVICE_PATH));
+
+    // Then
+    ASSERT_TRUE(wolkabout::Scanner::getDevices().empty());
+}
+
+TEST_F(AdvertisementMonitor, Given_InactiveMonitor_When_DeviceIsFound_Then_ItIsIgnored)
+{
+    // Given
+    monitor->register_monitor();
+    ASSERT_TRUE(wait_for([&] { return !bluez.monitor.empty(); }));
+
+    // When
+    call("DeviceFound", g_variant_new("(o)", DEVICE_PATH));
+
+    // Then
+    ASSERT_FALSE(wait_for([&] { return device_held(); }, G_USEC_PER_SEC / 5));
+}
+
+TEST_F(AdvertisementMonitor, Given_ActiveMonitor_When_Released_Then_DiscoveryResumesAndDevicesAreNoLongerHeld)
+{
+    // Given
+    worker->start_scan();
+    activate();
+    call("DeviceFound", g_variant_new("(o)", DEVICE_PATH));
+    ASSERT_TRUE(wait_for([&] { return device_held(); }));
+    ASSERT_TRUE(wait_for([&] { return bluez.discovery_stopped == 1; }));
+
+    // When
+    call("Release");
+
+    // Then
+    ASSERT_FALSE(monitor->active());
+    ASSERT_EQ(activations, (std::vector<bool>{true, false}));
+    ASSERT_TRUE(wait_for([&] { return bluez.discovery_started == 2; }));
+    ASSERT_FALSE(device_held());
+}
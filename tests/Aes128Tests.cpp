@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Aes128.h"
+
+#include <glib.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::vector<guint8> bytes(const std::string& hex)
+{
+    std::vector<guint8> data;
+    for (std::string::size_type i = 0; i + 1 < hex.size(); i += 2)
+    {
+        data.push_back(static_cast<guint8>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+    }
+    return data;
+}
+
+std::vector<guint8> encrypt(const std::string& key, const std::string& plaintext)
+{
+    guint8 round_keys[wolkabout::AES128_ROUND_KEYS_SIZE];
+    wolkabout::aes128_expand_key(bytes(key).data(), round_keys);
+
+    std::vector<guint8> ciphertext(wolkabout::AES128_BLOCK_SIZE);
+    wolkabout::aes128_encrypt(round_keys, bytes(plaintext).data(), ciphertext.data());
+    return ciphertext;
+}
+}    // namespace
+
+TEST(Aes128, Given_Fips197ExampleVector_When_Encrypted_Then_TheCiphertextMatches)
+{
+    // FIPS-197 Appendix C.1
+    ASSERT_EQ(encrypt("000102030405060708090a0b0c0d0e0f", "00112233445566778899aabbccddeeff"),
+              bytes("69c4e0d86a7b0430d8cdb78070b4c55a"));
+}
+
+TEST(Aes128, Given_Fips197CipherExample_When_Encrypted_Then_TheCiphertextMatches)
+{
+    // FIPS-197 Appendix B
+    ASSERT_EQ(encrypt("2b7e151628aed2a6abf7158809cf4f3c", "3243f6a8885a308d313198a2e0370734"),
+              bytes("3925841d02dc09fbdc118597196a0b32"));
+}
+
+TEST(Aes128, Given_Fips197Key_When_Expanded_Then_TheLastRoundKeyMatches)
+{
+    // Given
+    guint8 round_keys[wolkabout::AES128_ROUND_KEYS_SIZE];
+
+    // When
+    wolkabout::aes128_expand_key(bytes("2b7e151628aed2a6abf7158809cf4f3c").data(), round_keys);
+
+    // Then
+    ASSERT_EQ(std::vector<guint8>(round_keys + 160, round_keys + 176), bytes("d014f9a8c9ee2589e13f0cc8b6630ca6"));
+}
+
+TEST(Aes128, Given_SeveralKeys_When_EncryptedInBatch_Then_EachBlockMatchesSingleEncryption)
+{
+    // Given, a count that is not a multiple of the interleaving width
+    const gsize count = 9;
+    const std::vector<guint8> plaintext = bytes("00000000000000000000000000708194");
+    std::vector<guint8> round_keys(count * wolkabout::AES128_ROUND_KEYS_SIZE);
+    for (gsize i = 0; i < count; ++i)
+    {
+        guint8 key[wolkabout::AES128_BLOCK_SIZE];
+        for (gsize j = 0; j < sizeof(key); ++j)
+        {
+            key[j] = static_cast<guint8>(i * 17 + j);
+        }
+        wolkabout::aes128_expand_key(key, &round_keys[i * wolkabout::AES128_ROUND_KEYS_SIZE]);
+    }
+
+    // When
+    std::vector<guint8> batch(count * wolkabout::AES128_BLOCK_SIZE);
+    wolkabout::aes128_encrypt_batch(round_keys.data(), count, plaintext.data(), batch.data());
+
+    // Then
+    for (gsize i = 0; i < count; ++i)
+    {
+        guint8 single[wolkabout::AES128_BLOCK_SIZE];
+        wolkabout::aes128_encrypt(&round_keys[i * wolkabout::AES128_ROUND_KEYS_SIZE], plaintext.data(), single);
+        ASSERT_EQ(std::vector<guint8>(batch.begin() + static_cast<long>(i * wolkabout::AES128_BLOCK_SIZE),
+                                      batch.begin() + static_cast<long>((i + 1) * wolkabout::AES128_BLOCK_SIZE)),
+                  std::vector<guint8>(single, single + wolkabout::AES128_BLOCK_SIZE))
+          << i;
+    }
+}
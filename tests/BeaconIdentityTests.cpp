@@ -0,0 +1,197 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BeaconIdentity.h"
+
+#include <algorithm>
+#include <glib.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+const char* const IBEACON_KEY = "IBEACON:F7826DA6-4FA2-4E98-8024-BC5B71E0893E:1:2";
+const char* const EDDYSTONE_KEY = "EDDYSTONE:00010203040506070809:0A0B0C0D0E0F";
+
+const guint8 IBEACON_PAYLOAD[] = {0x02, 0x15, 0xF7, 0x82, 0x6D, 0xA6, 0x4F, 0xA2, 0x4E, 0x98, 0x80, 0x24,
+                                  0xBC, 0x5B, 0x71, 0xE0, 0x89, 0x3E, 0x00, 0x01, 0x00, 0x02, 0xC5};
+
+const guint8 EDDYSTONE_UID_PAYLOAD[] = {0x00, 0xE7, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                        0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x00, 0x00};
+
+GVariant* byte_array(const guint8* data, gsize size)
+{
+    return g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, data, size, 1);
+}
+
+GVariant* manufacturer_data(guint16 company_id, const guint8* data, gsize size)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{qv}"));
+    g_variant_builder_add(&builder, "{qv}", company_id, byte_array(data, size));
+    return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
+
+GVariant* service_data(const char* uuid, const guint8* data, gsize size)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&builder, "{sv}", uuid, byte_array(data, size));
+    return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
+
+wolkabout::BeaconIndex index_of(const std::vector<std::string>& keys)
+{
+    wolkabout::BeaconIndex index;
+    for (const auto& key : keys)
+    {
+        wolkabout::BeaconIdentity identity;
+        if (wolkabout::parse_beacon_key(key, identity))
+            index.add(identity, key);
+    }
+    return index;
+}
+}    // namespace
+
+TEST(BeaconIdentity, Given_IBeaconKey_When_Parsed_Then_UuidMajorAndMinorAreTheIdentity)
+{
+    // Given
+    wolkabout::BeaconIdentity identity;
+
+    // When
+    const bool parsed = wolkabout::parse_beacon_key(IBEACON_KEY, identity);
+
+    // Then
+    ASSERT_TRUE(parsed);
+    ASSERT_EQ(identity.type, wolkabout::BeaconIdentity::IBEACON);
+    ASSERT_EQ(identity.size, 20);
+    ASSERT_EQ(std::vector<guint8>(identity.bytes, identity.bytes + 20),
+              std::vector<guint8>(IBEACON_PAYLOAD + 2, IBEACON_PAYLOAD + 22));
+}
+
+TEST(BeaconIdentity, Given_EddystoneKey_When_Parsed_Then_NamespaceAndInstanceAreTheIdentity)
+{
+    // Given
+    wolkabout::BeaconIdentity identity;
+
+    // When
+    const bool parsed = wolkabout::parse_beacon_key(EDDYSTONE_KEY, identity);
+
+    // Then
+    ASSERT_TRUE(parsed);
+    ASSERT_EQ(identity.type, wolkabout::BeaconIdentity::EDDYSTONE_UID);
+    ASSERT_EQ(identity.size, 16);
+    ASSERT_EQ(std::vector<guint8>(identity.bytes, identity.bytes + 16),
+              std::vector<guint8>(EDDYSTONE_UID_PAYLOAD + 2, EDDYSTONE_UID_PAYLOAD + 18));
+}
+
+TEST(BeaconIdentity, Given_KeysDifferingInCase_When_Parsed_Then_TheIdentitiesAreEqual)
+{
+    wolkabout::BeaconIdentity upper;
+    wolkabout::BeaconIdentity lower;
+
+    ASSERT_TRUE(wolkabout::parse_beacon_key(IBEACON_KEY, upper));
+    ASSERT_TRUE(wolkabout::parse_beacon_key("ibeacon:f7826da6-4fa2-4e98-8024-bc5b71e0893e:1:2", lower));
+    ASSERT_TRUE(upper == lower);
+    ASSERT_EQ(wolkabout::BeaconIdentityHash()(upper), wolkabout::BeaconIdentityHash()(lower));
+}
+
+TEST(BeaconIdentity, Given_MalformedKey_When_Parsed_Then_ItIsRejected)
+{
+    for (const char* key : {"", "AA:BB:CC:DD:EE:FF", "IBEACON:F7826DA6-4FA2-4E98-8024-BC5B71E0893E:1",
+                            "IBEACON:F7826DA6-4FA2-4E98-8024-BC5B71E0893E:65536:2",
+                            "IBEACON:F7826DA6-4FA2-4E98-8024-BC5B71E0893E:1:x",
+                            "IBEACON:F7826DA6-4FA2-4E98-8024-BC5B71E0893E:-1:2",
+                            "IBEACON:F7826DA6-4FA2-4E98-8024-BC5B71E0893:1:2",
+                            "IBEACON:G7826DA6-4FA2-4E98-8024-BC5B71E0893E:1:2", "EDDYSTONE:00010203040506070809",
+                            "EDDYSTONE:000102030405060708:0A0B0C0D0E0F", "EDDYSTONE:00010203040506070809:0A0B0C0D0E",
+                            "ALTBEACON:00010203040506070809:0A0B0C0D0E0F"})
+    {
+        wolkabout::BeaconIdentity identity;
+        ASSERT_FALSE(wolkabout::parse_beacon_key(key, identity)) << key;
+    }
+}
+
+TEST(BeaconIdentity, Given_IBeaconAdvertisement_When_Resolved_Then_ItsKeyIsFound)
+{
+    // Given
+    const wolkabout::BeaconIndex index = index_of({IBEACON_KEY, EDDYSTONE_KEY});
+    GVariant* data = manufacturer_data(0x004C, IBEACON_PAYLOAD, sizeof(IBEACON_PAYLOAD));
+
+    // When
+    const std::string* key = index.resolve(data, NULL);
+
+    // Then
+    ASSERT_NE(key, nullptr);
+    ASSERT_EQ(*key, IBEACON_KEY);
+    g_variant_unref(data);
+}
+
+TEST(BeaconIdentity, Given_IBeaconLayoutOfOtherCompany_When_Resolved_Then_NoKeyIsFound)
+{
+    const wolkabout::BeaconIndex index = index_of({IBEACON_KEY});
+    GVariant* other_company = manufacturer_data(0x0499, IBEACON_PAYLOAD, sizeof(IBEACON_PAYLOAD));
+    GVariant* truncated = manufacturer_data(0x004C, IBEACON_PAYLOAD, sizeof(IBEACON_PAYLOAD) - 1);
+
+    ASSERT_EQ(index.resolve(other_company, NULL), nullptr);
+    ASSERT_EQ(index.resolve(truncated, NULL), nullptr);
+
+    g_variant_unref(other_company);
+    g_variant_unref(truncated);
+}
+
+TEST(BeaconIdentity, Given_EddystoneUidFrame_When_Resolved_Then_ItsKeyIsFound)
+{
+    // Given
+    const wolkabout::BeaconIndex index = index_of({IBEACON_KEY, EDDYSTONE_KEY});
+    GVariant* data =
+      service_data("0000FEAA-0000-1000-8000-00805F9B34FB", EDDYSTONE_UID_PAYLOAD, sizeof(EDDYSTONE_UID_PAYLOAD));
+
+    // When
+    const std::string* key = index.resolve(NULL, data);
+
+    // Then
+    ASSERT_NE(key, nullptr);
+    ASSERT_EQ(*key, EDDYSTONE_KEY);
+    g_variant_unref(data);
+}
+
+TEST(BeaconIdentity, Given_OtherEddystoneFrameOrService_When_Resolved_Then_NoKeyIsFound)
+{
+    const wolkabout::BeaconIndex index = index_of({EDDYSTONE_KEY});
+    guint8 tlm[sizeof(EDDYSTONE_UID_PAYLOAD)];
+    std::copy(EDDYSTONE_UID_PAYLOAD, EDDYSTONE_UID_PAYLOAD + sizeof(tlm), tlm);
+    tlm[0] = 0x20;
+    GVariant* tlm_frame = service_data("0000feaa-0000-1000-8000-00805f9b34fb", tlm, sizeof(tlm));
+    GVariant* other_service =
+      service_data("0000181a-0000-1000-8000-00805f9b34fb", EDDYSTONE_UID_PAYLOAD, sizeof(EDDYSTONE_UID_PAYLOAD));
+
+    ASSERT_EQ(index.resolve(NULL, tlm_frame), nullptr);
+    ASSERT_EQ(index.resolve(NULL, other_service), nullptr);
+
+    g_variant_unref(tlm_frame);
+    g_variant_unref(other_service);
+}
+
+TEST(BeaconIdentity, Given_UnknownBeacon_When_Resolved_Then_NoKeyIsFound)
+{
+    const wolkabout::BeaconIndex index = index_of({"IBEACON:F7826DA6-4FA2-4E98-8024-BC5B71E0893E:1:3"});
+    GVariant* data = manufacturer_data(0x004C, IBEACON_PAYLOAD, sizeof(IBEACON_PAYLOAD));
+
+    ASSERT_EQ(index.resolve(data, NULL), nullptr);
+    g_variant_unref(data);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CborProtocol.h"
+#include "core/model/Message.h"
+#include "core/model/SensorReading.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::string bytes(std::initializer_list<unsigned char> list)
+{
+    return std::string(list.begin(), list.end());
+}
+
+std::string payload(const std::vector<std::shared_ptr<wolkabout::SensorReading>>& readings,
+                    const std::string& delimiter = ",")
+{
+    const auto message = wolkabout::CborProtocol().makeMessage("device", readings, delimiter);
+    return message ? message->getContent() : "";
+}
+
+std::string payload(const std::string& value, unsigned long long rtc = 0)
+{
+    return payload({std::make_shared<wolkabout::SensorReading>(value, "P", rtc)});
+}
+
+// One reading without rtc, [["P", <value>]]
+std::string reading(const std::string& value)
+{
+    return bytes({0x81, 0x82, 0x61, 'P'}) + value;
+}
+}    // namespace
+
+TEST(CborProtocol, Given_NoReadings_When_MessageIsMade_Then_NoMessageIsReturned)
+{
+    ASSERT_EQ(wolkabout::CborProtocol().makeMessage("device", {}, ","), nullptr);
+}
+
+TEST(CborProtocol, Given_Reading_When_MessageIsMade_Then_ItIsSentOnTheDeviceReadingTopic)
+{
+    // Given
+    std::vector<std::shared_ptr<wolkabout::SensorReading>> readings{
+      std::make_shared<wolkabout::SensorReading>("1", "P")};
+
+    // When
+    const auto message = wolkabout::CborProtocol().makeMessage("AA:BB", readings, ",");
+
+    // Then
+    ASSERT_NE(message, nullptr);
+    ASSERT_EQ(message->getChannel(), "d2p/sensor_reading/d/AA:BB");
+}
+
+TEST(CborProtocol, Given_SmallInteger_When_Encoded_Then_ItIsPackedIntoTheHead)
+{
+    ASSERT_EQ(payload("0"), reading(bytes({0x00})));
+    ASSERT_EQ(payload("23"), reading(bytes({0x17})));
+}
+
+TEST(CborProtocol, Given_LargerIntegers_When_Encoded_Then_TheShortestLengthIsUsed)
+{
+    ASSERT_EQ(payload("24"), reading(bytes({0x18, 0x18})));
+    ASSERT_EQ(payload("255"), reading(bytes({0x18, 0xff})));
+    ASSERT_EQ(payload("256"), reading(bytes({0x19, 0x01, 0x00})));
+    ASSERT_EQ(payload("65536"), reading(bytes({0x1a, 0x00, 0x01, 0x00, 0x00})));
+    ASSERT_EQ(payload("4294967296"), reading(bytes({0x1b, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00})));
+}
+
+TEST(CborProtocol, Given_NegativeInteger_When_Encoded_Then_ItIsEncodedAsNegative)
+{
+    ASSERT_EQ(payload("-1"), reading(bytes({0x20})));
+    ASSERT_EQ(payload("-71"), reading(bytes({0x38, 0x46})));
+}
+
+TEST(CborProtocol, Given_Real_When_Encoded_Then_ItIsEncodedAsDouble)
+{
+    ASSERT_EQ(payload("21.5"), reading(bytes({0xfb, 0x40, 0x35, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00})));
+    ASSERT_EQ(payload("-0.5"), reading(bytes({0xfb, 0xbf, 0xe0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00})));
+}
+
+TEST(CborProtocol, Given_RealWithExponent_When_Encoded_Then_ItIsEncodedAsDouble)
+{
+    ASSERT_EQ(payload("1.5e2"), reading(bytes({0xfb, 0x40, 0x62, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00})));
+    ASSERT_EQ(payload("1E3"), reading(bytes({0xfb, 0x40, 0x8f, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00})));
+}
+
+TEST(CborProtocol, Given_IntegerBeyondRange_When_Encoded_Then_ItIsEncodedAsDouble)
+{
+    ASSERT_EQ(payload("18446744073709551616"), reading(bytes({0xfb, 0x43, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00})));
+}
+
+TEST(CborProtocol, Given_NonDecimalNumberText_When_Encoded_Then_ItIsEncodedAsTextString)
+{
+    for (const char* value : {"0x1A", "nan", "NAN", "inf", "-inf", "infinity", " 5", "5 ", "007", "-01", "+5", ".5",
+                              "5.", "1e", "1e+", "-", "1.5.2", "1e999"})
+    {
+        const std::string text(value);
+        ASSERT_EQ(payload(text), reading(bytes({static_cast<unsigned char>(0x60 + text.size())}) + text)) << value;
+    }
+}
+
+TEST(CborProtocol, Given_Boolean_When_Encoded_Then_ItIsEncodedAsSimpleValue)
+{
+    ASSERT_EQ(payload("true"), reading(bytes({0xf5})));
+    ASSERT_EQ(payload("false"), reading(bytes({0xf4})));
+}
+
+TEST(CborProtocol, Given_Text_When_Encoded_Then_ItIsEncodedAsTextString)
+{
+    ASSERT_EQ(payload(""), reading(bytes({0x60})));
+    ASSERT_EQ(payload("on"), reading(bytes({0x62, 'o', 'n'})));
+    ASSERT_EQ(payload(std::string(24, 'a')), reading(bytes({0x78, 0x18}) + std::string(24, 'a')));
+}
+
+TEST(CborProtocol, Given_ReadingWithRtc_When_Encoded_Then_RtcIsTheThirdElement)
+{
+    ASSERT_EQ(payload("1", 1546300800000ULL),
+              bytes({0x81, 0x83, 0x61, 'P', 0x01, 0x1b, 0x00, 0x00, 0x01, 0x68, 0x06, 0xb5, 0xbc, 0x00}));
+}
+
+TEST(CborProtocol, Given_MultiValueReading_When_Encoded_Then_ValuesAreEncodedAsArray)
+{
+    ASSERT_EQ(payload("1,-1,on"), reading(bytes({0x83, 0x01, 0x20, 0x62, 'o', 'n'})));
+}
+
+TEST(CborProtocol, Given_NoDelimiter_When_Encoded_Then_TheValueIsNotSplit)
+{
+    ASSERT_EQ(payload({std::make_shared<wolkabout::SensorReading>("1,2", "P")}, ""),
+              reading(bytes({0x63, '1', ',', '2'})));
+}
+
+TEST(CborProtocol, Given_SeveralReadings_When_Encoded_Then_TheyAreElementsOfOneArray)
+{
+    // Given
+    std::vector<std::shared_ptr<wolkabout::SensorReading>> readings{
+      std::make_shared<wolkabout::SensorReading>("1", "P"), std::make_shared<wolkabout::SensorReading>("-2", "S")};
+
+    // When
+    const auto encoded = payload(readings);
+
+    // Then
+    ASSERT_EQ(encoded, bytes({0x82, 0x82, 0x61, 'P', 0x01, 0x82, 0x61, 'S', 0x21}));
+}
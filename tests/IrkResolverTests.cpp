@@ -0,0 +1,186 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IrkResolver.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace
+{
+// Sample data of the ah function in the Bluetooth Core specification, Vol 3, Part H, D.7:
+// the IRK hashes prand 0x708194 to 0x0DFBAA
+const char* const SAMPLE_IRK = "ec0234a357c8ad05341010a60a397d9b";
+const char* const SAMPLE_ADDRESS = "70:81:94:0D:FB:AA";
+const char* const OTHER_IRK = "000102030405060708090a0b0c0d0e0f";
+
+wolkabout::IdentityResolvingKey irk_of(const char* hex)
+{
+    wolkabout::IdentityResolvingKey irk;
+    EXPECT_TRUE(wolkabout::parse_irk(hex, irk));
+    return irk;
+}
+}    // namespace
+
+TEST(IrkResolver, Given_Hex_When_Parsed_Then_MostSignificantOctetIsFirst)
+{
+    // Given
+    wolkabout::IdentityResolvingKey irk;
+
+    // When
+    const bool parsed = wolkabout::parse_irk(SAMPLE_IRK, irk);
+
+    // Then
+    ASSERT_TRUE(parsed);
+    ASSERT_EQ(irk.bytes[0], 0xEC);
+    ASSERT_EQ(irk.bytes[1], 0x02);
+    ASSERT_EQ(irk.bytes[15], 0x9B);
+}
+
+TEST(IrkResolver, Given_MalformedHex_When_Parsed_Then_ItIsRejected)
+{
+    wolkabout::IdentityResolvingKey irk;
+    for (const char* hex : {"", "ec0234a357c8ad05341010a60a397d9", "ec0234a357c8ad05341010a60a397d9b00",
+                            "ec0234a357c8ad05341010a60a397d9g", "ec0234a3-7c8ad05341010a60a397d9b"})
+    {
+        ASSERT_FALSE(wolkabout::parse_irk(hex, irk)) << hex;
+    }
+}
+
+TEST(IrkResolver, Given_Addresses_When_Checked_Then_OnlyResolvablePrivateAddressesAreResolvable)
+{
+    ASSERT_TRUE(wolkabout::IrkResolver::is_resolvable(SAMPLE_ADDRESS));
+    ASSERT_TRUE(wolkabout::IrkResolver::is_resolvable("40:00:00:00:00:00"));
+    ASSERT_TRUE(wolkabout::IrkResolver::is_resolvable("7F:FF:FF:FF:FF:FF"));
+
+    // Static random and non-resolvable private addresses
+    ASSERT_FALSE(wolkabout::IrkResolver::is_resolvable("C0:00:00:00:00:00"));
+    ASSERT_FALSE(wolkabout::IrkResolver::is_resolvable("3F:FF:FF:FF:FF:FF"));
+    ASSERT_FALSE(wolkabout::IrkResolver::is_resolvable("80:00:00:00:00:00"));
+    ASSERT_FALSE(wolkabout::IrkResolver::is_resolvable("70:81:94:0D:FB"));
+}
+
+TEST(IrkResolver, Given_SpecificationSampleData_When_Resolved_Then_TheAddressBelongsToTheIrk)
+{
+    // Given
+    wolkabout::IrkResolver resolver;
+    resolver.add(irk_of(OTHER_IRK), "OTHER");
+    resolver.add(irk_of(SAMPLE_IRK), "SAMPLE");
+
+    // When
+    const std::string* key = resolver.resolve(SAMPLE_ADDRESS);
+
+    // Then
+    ASSERT_NE(key, nullptr);
+    ASSERT_EQ(*key, "SAMPLE");
+}
+
+TEST(IrkResolver, Given_OtherHash_When_Resolved_Then_NoKeyIsFound)
+{
+    wolkabout::IrkResolver resolver;
+    resolver.add(irk_of(SAMPLE_IRK), "SAMPLE");
+
+    ASSERT_EQ(resolver.resolve("70:81:94:0D:FB:AB"), nullptr);
+    ASSERT_EQ(resolver.resolve("70:81:95:0D:FB:AA"), nullptr);
+}
+
+TEST(IrkResolver, Given_NoKeysOrMalformedAddress_When_Resolved_Then_NoKeyIsFound)
+{
+    wolkabout::IrkResolver resolver;
+    ASSERT_EQ(resolver.resolve(SAMPLE_ADDRESS), nullptr);
+
+    resolver.add(irk_of(SAMPLE_IRK), "SAMPLE");
+    ASSERT_EQ(resolver.resolve("70-81-94-0D-FB-AA"), nullptr);
+    ASSERT_EQ(resolver.resolve(""), nullptr);
+}
+
+TEST(IrkResolver, Given_CachedOutcomes_When_ResolvedAgain_Then_TheyAreRepeated)
+{
+    // Given
+    wolkabout::IrkResolver resolver;
+    resolver.add(irk_of(SAMPLE_IRK), "SAMPLE");
+    const std::string* first = resolver.resolve(SAMPLE_ADDRESS);
+    ASSERT_EQ(resolver.resolve("70:81:94:0D:FB:AB"), nullptr);
+
+    // When
+    const std::string* second = resolver.resolve(SAMPLE_ADDRESS);
+
+    // Then
+    ASSERT_NE(first, nullptr);
+    ASSERT_EQ(first, second);
+    ASSERT_EQ(resolver.resolve("70:81:94:0D:FB:AB"), nullptr);
+}
+
+TEST(IrkResolver, Given_NegativelyCachedAddress_When_ItsIrkIsAdded_Then_ItResolves)
+{
+    // Given
+    wolkabout::IrkResolver resolver;
+    resolver.add(irk_of(OTHER_IRK), "OTHER");
+    ASSERT_EQ(resolver.resolve(SAMPLE_ADDRESS), nullptr);
+
+    // When
+    resolver.add(irk_of(SAMPLE_IRK), "SAMPLE");
+
+    // Then
+    const std::string* key = resolver.resolve(SAMPLE_ADDRESS);
+    ASSERT_NE(key, nullptr);
+    ASSERT_EQ(*key, "SAMPLE");
+}
+
+TEST(IrkResolver, Given_FullCache_When_NewAddressesResolve_Then_OldestEntriesAreEvicted)
+{
+    // Given
+    wolkabout::IrkResolver resolver(2);
+    resolver.add(irk_of(SAMPLE_IRK), "SAMPLE");
+    ASSERT_NE(resolver.resolve(SAMPLE_ADDRESS), nullptr);
+
+    // When
+    ASSERT_EQ(resolver.resolve("40:00:00:00:00:01"), nullptr);
+    ASSERT_EQ(resolver.resolve("40:00:00:00:00:02"), nullptr);
+
+    // Then, the evicted address is tried again with the same outcome
+    const std::string* key = resolver.resolve(SAMPLE_ADDRESS);
+    ASSERT_NE(key, nullptr);
+    ASSERT_EQ(*key, "SAMPLE");
+}
+
+TEST(IrkResolver, Given_ResolvedAddresses_When_LookedUpInCache_Then_OnlyPositiveOutcomesAreReturned)
+{
+    // Given
+    wolkabout::IrkResolver resolver;
+    resolver.add(irk_of(SAMPLE_IRK), "SAMPLE");
+    ASSERT_EQ(resolver.cached(SAMPLE_ADDRESS), nullptr);
+    resolver.resolve(SAMPLE_ADDRESS);
+    resolver.resolve("70:81:94:0D:FB:AB");
+
+    // When
+    const std::string* key = resolver.cached(SAMPLE_ADDRESS);
+
+    // Then
+    ASSERT_NE(key, nullptr);
+    ASSERT_EQ(*key, "SAMPLE");
+    ASSERT_EQ(resolver.cached("70:81:94:0D:FB:AB"), nullptr);
+    ASSERT_EQ(resolver.cached("40:00:00:00:00:01"), nullptr);
+}
+
+TEST(IrkResolver, Given_ExpiredOutcome_When_LookedUpInCache_Then_ItIsNotReturned)
+{
+    wolkabout::IrkResolver resolver(16, 0);
+    resolver.add(irk_of(SAMPLE_IRK), "SAMPLE");
+
+    ASSERT_NE(resolver.resolve(SAMPLE_ADDRESS), nullptr);
+    ASSERT_EQ(resolver.cached(SAMPLE_ADDRESS), nullptr);
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PresenceHistory.h"
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/stat.h>
+
+namespace
+{
+const guint32 FINGERPRINT = 0x1234;
+
+// One day of minutes, 1440 intervals rounded up to 1472 slots
+const wolkabout::HistorySettings SETTINGS = {60, 1};
+const guint64 SLOTS = 1472;
+
+// Start of an interval
+const guint64 BASE = 1700000000 / 60 * 60;
+
+class PresenceHistory : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        path = ::testing::TempDir() + "PresenceHistoryTests.bin";
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::string path;
+};
+}    // namespace
+
+TEST(HistorySettings, Given_ZeroResolutionOrRetention_When_Validated_Then_TheyAreRejected)
+{
+    ASSERT_TRUE(wolkabout::valid_history_settings(wolkabout::PresenceHistory::DEFAULT_SETTINGS));
+    ASSERT_FALSE(wolkabout::valid_history_settings({0, 7}));
+    ASSERT_FALSE(wolkabout::valid_history_settings({60, 0}));
+}
+
+TEST_F(PresenceHistory, Given_Devices_When_Opened_Then_EachGetsWholeWordsForTheRetentionPeriod)
+{
+    // When
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 2, FINGERPRINT, SETTINGS));
+
+    // Then
+    struct stat st;
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    ASSERT_EQ(static_cast<guint64>(st.st_size), 32 + 2 * SLOTS / 8);
+}
+
+TEST_F(PresenceHistory, Given_DefaultSettings_When_Opened_Then_ADeviceTakes10112Bits)
+{
+    // When
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT, wolkabout::PresenceHistory::DEFAULT_SETTINGS));
+
+    // Then
+    struct stat st;
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    ASSERT_EQ(static_cast<guint64>(st.st_size), 32 + 10112 / 8);
+}
+
+TEST_F(PresenceHistory, Given_EmptyHistory_When_Queried_Then_TheDeviceWasNeverPresent)
+{
+    // Given
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+
+    // When
+    const auto summary = history.query(0, 0, BASE);
+
+    // Then
+    ASSERT_EQ(summary.ratio, 0);
+    ASSERT_EQ(summary.first_seen, 0u);
+    ASSERT_EQ(summary.last_seen, 0u);
+}
+
+TEST_F(PresenceHistory, Given_MarkedPresence_When_Queried_Then_ShareAndBoundsOfThePresentIntervalsAreReturned)
+{
+    // Given
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 2, FINGERPRINT, SETTINGS));
+    history.advance(BASE);
+    history.mark(0, BASE + 60, BASE + 179);
+    history.advance(BASE + 540);
+
+    // When
+    const auto summary = history.query(0, BASE, BASE + 600);
+
+    // Then
+    ASSERT_DOUBLE_EQ(summary.ratio, 0.2);
+    ASSERT_EQ(summary.first_seen, BASE + 60);
+    ASSERT_EQ(summary.last_seen, BASE + 180);
+    ASSERT_EQ(history.query(1, BASE, BASE + 600).ratio, 0);
+}
+
+TEST_F(PresenceHistory, Given_PresenceAcrossWords_When_Queried_Then_EveryIntervalIsCounted)
+{
+    // Given
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+    history.advance(BASE);
+    history.mark(0, BASE + 30 * 60, BASE + 229 * 60);
+    history.advance(BASE + 299 * 60);
+
+    // When
+    const auto summary = history.query(0, BASE, BASE + 300 * 60);
+
+    // Then
+    ASSERT_DOUBLE_EQ(summary.ratio, 200.0 / 300.0);
+    ASSERT_EQ(summary.first_seen, BASE + 30 * 60);
+    ASSERT_EQ(summary.last_seen, BASE + 230 * 60);
+}
+
+TEST_F(PresenceHistory, Given_RangeBeyondTheNewestInterval_When_Queried_Then_OnlyStartedIntervalsAreCounted)
+{
+    // Given
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+    history.advance(BASE);
+    history.mark(0, BASE, BASE + 59);
+
+    // When
+    const auto summary = history.query(0, BASE, BASE + 3600);
+
+    // Then
+    ASSERT_DOUBLE_EQ(summary.ratio, 1);
+}
+
+TEST_F(PresenceHistory, Given_PresenceOlderThanTheRetention_When_IntervalsAdvance_Then_ItIsCleared)
+{
+    // Given
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+    history.advance(BASE);
+    history.mark(0, BASE, BASE);
+
+    // When
+    history.advance(BASE + SLOTS * 60);
+
+    // Then
+    ASSERT_EQ(history.query(0, BASE, BASE + (SLOTS + 1) * 60).ratio, 0);
+}
+
+TEST_F(PresenceHistory, Given_PresenceInTheRing_When_IntervalsAdvance_Then_RetainedIntervalsAreKept)
+{
+    // Given
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+    history.advance(BASE);
+    history.mark(0, BASE + 60, BASE + 60);
+
+    // When
+    history.advance(BASE + SLOTS * 60);
+
+    // Then
+    const auto summary = history.query(0, BASE, BASE + (SLOTS + 1) * 60);
+    ASSERT_DOUBLE_EQ(summary.ratio, 1.0 / static_cast<double>(SLOTS));
+    ASSERT_EQ(summary.first_seen, BASE + 60);
+}
+
+TEST_F(PresenceHistory, Given_MarkBeforeTheRetainedIntervals_When_Marked_Then_OnlyRetainedIntervalsAreSet)
+{
+    // Given
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+    history.advance(BASE + SLOTS * 60);
+
+    // When
+    history.mark(0, BASE, BASE + SLOTS * 60);
+
+    // Then
+    const auto summary = history.query(0, BASE, BASE + (SLOTS + 1) * 60);
+    ASSERT_DOUBLE_EQ(summary.ratio, 1);
+    ASSERT_EQ(summary.first_seen, BASE + 60);
+}
+
+TEST_F(PresenceHistory, Given_StoredHistory_When_ReopenedWithTheSameDevicesAndSettings_Then_ItIsKept)
+{
+    // Given
+    {
+        wolkabout::PresenceHistory history;
+        ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+        history.advance(BASE);
+        history.mark(0, BASE, BASE + 59);
+    }
+
+    // When
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+
+    // Then
+    ASSERT_DOUBLE_EQ(history.query(0, BASE, BASE + 60).ratio, 1);
+}
+
+TEST_F(PresenceHistory, Given_StoredHistory_When_ReopenedWithOtherDevices_Then_ItIsDiscarded)
+{
+    // Given
+    {
+        wolkabout::PresenceHistory history;
+        ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+        history.advance(BASE);
+        history.mark(0, BASE, BASE + 59);
+    }
+
+    // When
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT + 1, SETTINGS));
+
+    // Then
+    ASSERT_EQ(history.query(0, BASE, BASE + 60).ratio, 0);
+}
+
+TEST_F(PresenceHistory, Given_StoredHistory_When_ReopenedWithAnotherResolution_Then_ItIsDiscarded)
+{
+    // Given
+    {
+        wolkabout::PresenceHistory history;
+        ASSERT_TRUE(history.open(path, 1, FINGERPRINT, SETTINGS));
+        history.advance(BASE);
+        history.mark(0, BASE, BASE + 59);
+    }
+
+    // When
+    wolkabout::PresenceHistory history;
+    ASSERT_TRUE(history.open(path, 1, FINGERPRINT, {30, 1}));
+
+    // Then
+    ASSERT_EQ(history.query(0, BASE, BASE + 60).ratio, 0);
+}
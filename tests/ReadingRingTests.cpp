@@ -0,0 +1,199 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ReadingRing.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+const guint32 FINGERPRINT = 0x1234;
+
+// Header and four 32 byte records
+const gsize BUDGET = 32 + 4 * 32;
+
+class ReadingRing : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        path = ::testing::TempDir() + "ReadingRingTests.ring";
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::string path;
+};
+}    // namespace
+
+TEST_F(ReadingRing, Given_TooSmallBudget_When_Opened_Then_OpeningFails)
+{
+    wolkabout::ReadingRing ring;
+    ASSERT_FALSE(ring.open(path, 32, FINGERPRINT));
+    ASSERT_FALSE(ring.is_open());
+}
+
+TEST_F(ReadingRing, Given_Readings_When_Appended_Then_TheyAreReadBackOldestFirst)
+{
+    // Given
+    wolkabout::ReadingRing ring;
+    ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT));
+
+    // When
+    ring.append(1, "P", 1, true, 1000);
+    ring.append(2, "T", 21.5, false, 2000);
+
+    // Then
+    ASSERT_EQ(ring.size(), 2u);
+    ASSERT_EQ(ring.front().device, 1u);
+    ASSERT_EQ(ring.front().integral, 1);
+    ASSERT_EQ(ring.front().rtc, 1000u);
+    ASSERT_EQ(ring.at(1).device, 2u);
+    ASSERT_DOUBLE_EQ(ring.at(1).value, 21.5);
+    ASSERT_EQ(ring.at(1).integral, 0);
+    ASSERT_EQ(std::string(ring.at(1).reference), "T");
+}
+
+TEST_F(ReadingRing, Given_LongReference_When_Appended_Then_SixCharactersAreKeptWithoutTerminator)
+{
+    // Given
+    wolkabout::ReadingRing ring;
+    ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT));
+
+    // When
+    ring.append(0, "ABCDEFGH", 0, true, 1);
+
+    // Then
+    ASSERT_EQ(std::string(ring.front().reference, sizeof(ring.front().reference)), "ABCDEF");
+}
+
+TEST_F(ReadingRing, Given_FullRing_When_Appended_Then_TheOldestReadingIsOverwrittenAndCounted)
+{
+    // Given
+    wolkabout::ReadingRing ring;
+    ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT));
+    for (guint32 i = 0; i < 4; ++i)
+        ring.append(i, "P", 1, true, i);
+
+    // When
+    ring.append(4, "P", 1, true, 4);
+    ring.append(5, "P", 1, true, 5);
+
+    // Then
+    ASSERT_EQ(ring.size(), 4u);
+    ASSERT_EQ(ring.front().device, 2u);
+    ASSERT_EQ(ring.at(3).device, 5u);
+    ASSERT_EQ(ring.collect_evicted(), 2u);
+    ASSERT_EQ(ring.collect_evicted(), 0u);
+}
+
+TEST_F(ReadingRing, Given_WrappedRing_When_Popped_Then_ReadingsFollowInOrder)
+{
+    // Given
+    wolkabout::ReadingRing ring;
+    ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT));
+    for (guint32 i = 0; i < 7; ++i)
+    {
+        ring.append(i, "P", 1, true, i);
+        if (i % 2 == 0)
+            ring.pop();
+    }
+
+    // When
+    std::vector<guint32> devices;
+    while (ring.size() > 0)
+    {
+        devices.push_back(ring.front().device);
+        ring.pop();
+    }
+
+    // Then
+    ASSERT_EQ(devices, (std::vector<guint32>{4, 5, 6}));
+}
+
+TEST_F(ReadingRing, Given_Readings_When_MoreArePoppedThanStored_Then_TheRingIsEmpty)
+{
+    // Given
+    wolkabout::ReadingRing ring;
+    ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT));
+    ring.append(0, "P", 1, true, 1);
+    ring.append(1, "P", 1, true, 2);
+
+    // When
+    ring.pop(5);
+    ring.append(2, "P", 1, true, 3);
+
+    // Then
+    ASSERT_EQ(ring.size(), 1u);
+    ASSERT_EQ(ring.front().device, 2u);
+}
+
+TEST_F(ReadingRing, Given_StoredReadings_When_ReopenedWithTheSameFingerprint_Then_TheyAreKept)
+{
+    // Given
+    {
+        wolkabout::ReadingRing ring;
+        ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT));
+        ring.append(3, "P", 0, true, 42);
+    }
+
+    // When
+    wolkabout::ReadingRing ring;
+    ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT));
+
+    // Then
+    ASSERT_EQ(ring.size(), 1u);
+    ASSERT_EQ(ring.front().device, 3u);
+    ASSERT_EQ(ring.front().rtc, 42u);
+}
+
+TEST_F(ReadingRing, Given_StoredReadings_When_ReopenedWithAnotherFingerprint_Then_TheyAreDiscarded)
+{
+    // Given
+    {
+        wolkabout::ReadingRing ring;
+        ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT));
+        ring.append(3, "P", 0, true, 42);
+    }
+
+    // When
+    wolkabout::ReadingRing ring;
+    ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT + 1));
+
+    // Then
+    ASSERT_EQ(ring.size(), 0u);
+}
+
+TEST_F(ReadingRing, Given_StoredReadings_When_ReopenedWithAnotherBudget_Then_TheyAreDiscarded)
+{
+    // Given
+    {
+        wolkabout::ReadingRing ring;
+        ASSERT_TRUE(ring.open(path, BUDGET, FINGERPRINT));
+        ring.append(3, "P", 0, true, 42);
+    }
+
+    // When
+    wolkabout::ReadingRing ring;
+    ASSERT_TRUE(ring.open(path, BUDGET + 32, FINGERPRINT));
+
+    // Then
+    ASSERT_EQ(ring.size(), 0u);
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RssiFilter.h"
+
+#include <glib.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+const float TOLERANCE = 1e-4f;
+
+// Kalman filter with unit process noise and a measurement noise of 4 dB²
+gsize add_kalman_slot(wolkabout::RssiFilter& filter)
+{
+    return filter.add_slot(1.0f, 4.0f, 0.0f, -59.0f, 2.0f);
+}
+}    // namespace
+
+TEST(RssiFilter, Given_FirstSamples_When_Updated_Then_TheirMeanIsTakenAsIs)
+{
+    // Given
+    wolkabout::RssiFilter filter;
+    const gsize slot = add_kalman_slot(filter);
+    filter.add(slot, -60.0f);
+    filter.add(slot, -70.0f);
+
+    // When
+    filter.update();
+
+    // Then
+    ASSERT_TRUE(filter.updated(slot));
+    ASSERT_NEAR(filter.rssi(slot), -65.0f, TOLERANCE);
+}
+
+TEST(RssiFilter, Given_NoSamples_When_Updated_Then_TheEstimateIsKept)
+{
+    // Given
+    wolkabout::RssiFilter filter;
+    const gsize slot = add_kalman_slot(filter);
+    filter.add(slot, -60.0f);
+    filter.update();
+
+    // When
+    filter.update();
+
+    // Then
+    ASSERT_FALSE(filter.updated(slot));
+    ASSERT_NEAR(filter.rssi(slot), -60.0f, TOLERANCE);
+}
+
+TEST(RssiFilter, Given_KalmanSlot_When_NextSampleArrives_Then_ItIsWeighedByTheVariances)
+{
+    // Given
+    wolkabout::RssiFilter filter;
+    const gsize slot = add_kalman_slot(filter);
+    filter.add(slot, -60.0f);
+    filter.update();
+
+    // When
+    filter.add(slot, -70.0f);
+    filter.update();
+
+    // Then, the gain is (4 + 1) / (4 + 1 + 4)
+    ASSERT_NEAR(filter.rssi(slot), -60.0f - 10.0f * 5.0f / 9.0f, TOLERANCE);
+}
+
+TEST(RssiFilter, Given_KalmanSlot_When_MoreSamplesArrive_Then_TheyMoveTheEstimateFurther)
+{
+    // Given
+    wolkabout::RssiFilter filter;
+    const gsize one = add_kalman_slot(filter);
+    const gsize two = add_kalman_slot(filter);
+    filter.add(one, -60.0f);
+    filter.add(two, -60.0f);
+    filter.update();
+
+    // When
+    filter.add(one, -70.0f);
+    filter.add(two, -70.0f);
+    filter.add(two, -70.0f);
+    filter.update();
+
+    // Then, two samples halve the measurement noise
+    ASSERT_NEAR(filter.rssi(one), -60.0f - 10.0f * 5.0f / 9.0f, TOLERANCE);
+    ASSERT_NEAR(filter.rssi(two), -60.0f - 10.0f * 5.0f / 7.0f, TOLERANCE);
+}
+
+TEST(RssiFilter, Given_KalmanSlotNotHeard_When_SampleArrives_Then_GrownUncertaintyGivesItMoreWeight)
+{
+    // Given
+    wolkabout::RssiFilter filter;
+    const gsize slot = add_kalman_slot(filter);
+    filter.add(slot, -60.0f);
+    filter.update();
+    filter.update();
+
+    // When
+    filter.add(slot, -70.0f);
+    filter.update();
+
+    // Then, the gain is (4 + 1 + 1) / (4 + 1 + 1 + 4)
+    ASSERT_NEAR(filter.rssi(slot), -66.0f, TOLERANCE);
+}
+
+TEST(RssiFilter, Given_FixedGain_When_SamplesArrive_Then_TheyAreExponentiallySmoothed)
+{
+    // Given
+    wolkabout::RssiFilter filter;
+    const gsize slot = filter.add_slot(1.0f, 4.0f, 0.3f, -59.0f, 2.0f);
+    filter.add(slot, -60.0f);
+    filter.update();
+
+    // When
+    filter.add(slot, -70.0f);
+    filter.update();
+    filter.add(slot, -70.0f);
+    filter.update();
+
+    // Then
+    ASSERT_NEAR(filter.rssi(slot), -63.0f - 0.3f * 7.0f, TOLERANCE);
+}
+
+TEST(RssiFilter, Given_UnitGain_When_SamplesArrive_Then_TheEstimateIsTheirMean)
+{
+    // Given
+    wolkabout::RssiFilter filter;
+    const gsize slot = filter.add_slot(1.0f, 4.0f, 1.0f, -59.0f, 2.0f);
+    filter.add(slot, -60.0f);
+    filter.update();
+
+    // When
+    filter.add(slot, -70.0f);
+    filter.add(slot, -80.0f);
+    filter.update();
+
+    // Then
+    ASSERT_NEAR(filter.rssi(slot), -75.0f, TOLERANCE);
+}
+
+TEST(RssiFilter, Given_SeveralSlots_When_OneIsSampled_Then_TheOthersAreNotUpdated)
+{
+    // Given
+    wolkabout::RssiFilter filter;
+    const gsize heard = add_kalman_slot(filter);
+    const gsize silent = add_kalman_slot(filter);
+
+    // When
+    filter.add(heard, -50.0f);
+    filter.update();
+
+    // Then
+    ASSERT_TRUE(filter.updated(heard));
+    ASSERT_FALSE(filter.updated(silent));
+    ASSERT_NEAR(filter.rssi(heard), -50.0f, TOLERANCE);
+}
+
+TEST(RssiFilter, Given_FilteredRssi_When_DistanceIsComputed_Then_ItFollowsTheLogDistanceModel)
+{
+    // Given
+    wolkabout::RssiFilter filter;
+    const gsize one_metre = filter.add_slot(1.0f, 4.0f, 1.0f, -59.0f, 2.0f);
+    const gsize ten_metres = filter.add_slot(1.0f, 4.0f, 1.0f, -59.0f, 2.0f);
+    const gsize obstructed = filter.add_slot(1.0f, 4.0f, 1.0f, -59.0f, 3.0f);
+
+    // When
+    filter.add(one_metre, -59.0f);
+    filter.add(ten_metres, -79.0f);
+    filter.add(obstructed, -89.0f);
+    filter.update();
+
+    // Then
+    ASSERT_NEAR(filter.distance(one_metre), 1.0f, TOLERANCE);
+    ASSERT_NEAR(filter.distance(ten_metres), 10.0f, TOLERANCE);
+    ASSERT_NEAR(filter.distance(obstructed), 10.0f, TOLERANCE);
+}
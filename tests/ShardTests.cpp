@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Shard.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace
+{
+// The remainder by the largest count is the hash itself for all but one value
+const unsigned HASH = 0xFFFFFFFFu;
+}    // namespace
+
+TEST(Shard, Given_PublishedVectors_When_Hashed_Then_TheHashIs32BitFnv1a)
+{
+    ASSERT_EQ(wolkabout::shard_of("", HASH), 0x811C9DC5u);
+    ASSERT_EQ(wolkabout::shard_of("a", HASH), 0xE40C292Cu);
+    ASSERT_EQ(wolkabout::shard_of("foobar", HASH), 0xBF9CF968u);
+}
+
+TEST(Shard, Given_DeviceKeys_When_Sharded_Then_TheyKeepTheirShards)
+{
+    ASSERT_EQ(wolkabout::shard_of("AA:BB:CC:DD:EE:FF", HASH), 0x7561D12Fu);
+    ASSERT_EQ(wolkabout::shard_of("AA:BB:CC:DD:EE:FF", 2), 1u);
+    ASSERT_EQ(wolkabout::shard_of("AA:BB:CC:DD:EE:FF", 4), 3u);
+    ASSERT_EQ(wolkabout::shard_of("AA:BB:CC:DD:EE:FF", 16), 15u);
+
+    ASSERT_EQ(wolkabout::shard_of("C4:7C:8D:6A:12:01", 3), 0u);
+    ASSERT_EQ(wolkabout::shard_of("C4:7C:8D:6A:12:01", 4), 1u);
+
+    ASSERT_EQ(wolkabout::shard_of("IBEACON:F7826DA6-4FA2-4E98-8024-BC5B71E0893E:1:2", 4), 2u);
+    ASSERT_EQ(wolkabout::shard_of("EDDYSTONE:00010203040506070809:0A0B0C0D0E0F", 3), 2u);
+}
+
+TEST(Shard, Given_OneShard_When_Sharded_Then_EveryKeyIsInIt)
+{
+    ASSERT_EQ(wolkabout::shard_of("AA:BB:CC:DD:EE:FF", 1), 0u);
+    ASSERT_EQ(wolkabout::shard_of("C4:7C:8D:6A:12:01", 1), 0u);
+}
+
+TEST(Shard, Given_IndexBelowCount_When_Parsed_Then_SettingsAreSet)
+{
+    // Given
+    wolkabout::ShardSettings settings = {0, 0};
+
+    // When
+    const bool parsed = wolkabout::parse_shard("3/4", settings);
+
+    // Then
+    ASSERT_TRUE(parsed);
+    ASSERT_EQ(settings.index, 3u);
+    ASSERT_EQ(settings.count, 4u);
+}
+
+TEST(Shard, Given_MalformedShard_When_Parsed_Then_ItIsRejected)
+{
+    wolkabout::ShardSettings settings;
+    for (const char* text : {"", "4/4", "1/0", "1/", "/4", "1", "a/4", "1/4/2", "-1/4", "1 /4", "1/4 "})
+    {
+        ASSERT_FALSE(wolkabout::parse_shard(text, settings)) << text;
+    }
+}
+
+TEST(Shard, Given_Settings_When_Validated_Then_IndexMustBeBelowCount)
+{
+    ASSERT_TRUE(wolkabout::valid_shard_settings({0, 1}));
+    ASSERT_TRUE(wolkabout::valid_shard_settings({3, 4}));
+    ASSERT_FALSE(wolkabout::valid_shard_settings({0, 0}));
+    ASSERT_FALSE(wolkabout::valid_shard_settings({4, 4}));
+}
+
+TEST(Shard, Given_SeveralShards_When_PathIsSharded_Then_TheIndexIsAppended)
+{
+    ASSERT_EQ(wolkabout::shard_path("/var/lib/store", {2, 4}), "/var/lib/store.2");
+}
+
+TEST(Shard, Given_OneShardOrNoPath_When_PathIsSharded_Then_ItIsUnchanged)
+{
+    ASSERT_EQ(wolkabout::shard_path("/var/lib/store", {0, 1}), "/var/lib/store");
+    ASSERT_EQ(wolkabout::shard_path("", {2, 4}), "");
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TokenBucket.h"
+
+#include <gtest/gtest.h>
+
+TEST(TokenBucket, Given_FullBucket_When_BurstIsTaken_Then_TheNextEventIsRefused)
+{
+    // Given
+    wolkabout::TokenBucket bucket(1, 3, 0);
+
+    // When
+    const bool first = bucket.take(0);
+    const bool second = bucket.take(0);
+    const bool third = bucket.take(0);
+    const bool fourth = bucket.take(0);
+
+    // Then
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    ASSERT_TRUE(third);
+    ASSERT_FALSE(fourth);
+}
+
+TEST(TokenBucket, Given_EmptyBucket_When_LessThanATokenIsRefilled_Then_TheEventIsRefused)
+{
+    // Given
+    wolkabout::TokenBucket bucket(2, 1, 0);
+    bucket.take(0);
+
+    // When
+    const bool taken = bucket.take(G_USEC_PER_SEC / 2 - 1);
+
+    // Then
+    ASSERT_FALSE(taken);
+}
+
+TEST(TokenBucket, Given_EmptyBucket_When_ATokenIsRefilled_Then_OneEventIsAllowed)
+{
+    // Given
+    wolkabout::TokenBucket bucket(2, 1, 0);
+    bucket.take(0);
+
+    // When
+    const bool taken = bucket.take(G_USEC_PER_SEC / 2);
+
+    // Then
+    ASSERT_TRUE(taken);
+    ASSERT_FALSE(bucket.take(G_USEC_PER_SEC / 2));
+}
+
+TEST(TokenBucket, Given_LongIdlePeriod_When_Refilled_Then_TokensAreCappedAtTheBurst)
+{
+    // Given
+    wolkabout::TokenBucket bucket(10, 2, 0);
+    bucket.take(0);
+    bucket.take(0);
+
+    // When
+    const gint64 later = 3600 * static_cast<gint64>(G_USEC_PER_SEC);
+    const bool first = bucket.take(later);
+    const bool second = bucket.take(later);
+    const bool third = bucket.take(later);
+
+    // Then
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    ASSERT_FALSE(third);
+}
+
+TEST(TokenBucket, Given_SustainedRate_When_EventsArriveAtTheRate_Then_AllAreAllowed)
+{
+    // Given
+    wolkabout::TokenBucket bucket(100, 1, 0);
+    bucket.take(0);
+
+    // When
+    int allowed = 0;
+    for (gint64 i = 1; i <= 1000; ++i)
+    {
+        allowed += bucket.take(i * G_USEC_PER_SEC / 100) ? 1 : 0;
+    }
+
+    // Then
+    ASSERT_EQ(allowed, 1000);
+}